@@ -0,0 +1,449 @@
+/**Microbenchmarks for the optimizer kernels.  Each kernel is swept over
+population size and dimension; every case gets a warmup, then several
+repetitions of a fixed number of iterations, interleaved across the cases,
+and the per candidate time of each repetition is reported (min and median)
+together with the heap allocations made per iteration.  Setup work between
+iterations, such as reshuffling a population before sortNest, is not
+timed.
+
+Where the kernel allows perf_event_open (often not in containers or VMs),
+one more pass counts cycles, instructions, cache misses and branch misses
+in user space, reported per candidate; counters that cannot be opened are
+reported as null.  The counting pass is separate so that the system calls
+do not disturb the timings.
+
+Usage: bench [--no-counters] [output.json]; JSON goes to stdout if no file
+is given.*/
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <algorithm>
+#include <functional>
+#include <string>
+#include <vector>
+#include <memory>
+#include <new>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <cmath>
+#include <cstdint>
+#ifdef __linux__
+#include <sched.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+#include "cuckoo.h"
+#include "firefly.h"
+
+namespace {
+    std::size_t numAllocations=0;
+}
+void* operator new(std::size_t size){
+    ++numAllocations;
+    if(void* ptr=std::malloc(size)){
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+void operator delete(void* ptr) noexcept{
+    std::free(ptr);
+}
+void operator delete(void* ptr, std::size_t) noexcept{
+    std::free(ptr);
+}
+
+namespace {
+    typedef std::chrono::steady_clock Clock;
+    const int numWarmup=3;
+    //enough that an exact Mann-Whitney test survives compare's correction over every case
+    const int numReps=11;
+    //iterations per repetition are chosen so that a repetition takes about this long
+    const double targetRepSeconds=.02;
+
+    const int numCounters=4;
+    const char* counterNames[numCounters]={"cycles", "instructions", "cacheMisses", "branchMisses"};
+
+    /**Hardware counters of this thread, opened as one perf_event group so
+    that they count over the same intervals.  Counters that fail to open are
+    left out; if the cycle counter (the group leader) fails, none are
+    available.*/
+    class PerfCounters{
+    private:
+        int fds[numCounters];
+        int numOpen=0;
+        int slot[numCounters];//position of each counter in a group read, or -1
+        std::string status="unavailable";
+        #ifdef __linux__
+            int open(uint64_t config, int groupFd){
+                perf_event_attr attr;
+                std::memset(&attr, 0, sizeof(attr));
+                attr.size=sizeof(attr);
+                attr.type=PERF_TYPE_HARDWARE;
+                attr.config=config;
+                attr.disabled=groupFd<0;
+                attr.exclude_kernel=1;
+                attr.exclude_hv=1;
+                attr.read_format=PERF_FORMAT_GROUP;
+                return syscall(__NR_perf_event_open, &attr, 0, -1, groupFd, 0);
+            }
+        #endif
+    public:
+        PerfCounters(){
+            for(int i=0; i<numCounters; ++i){
+                fds[i]=-1;
+                slot[i]=-1;
+            }
+            #ifdef __linux__
+                const uint64_t configs[numCounters]={
+                    PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+                    PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES
+                };
+                fds[0]=open(configs[0], -1);
+                if(fds[0]<0){
+                    status=std::string("unavailable: ")+std::strerror(errno);
+                    return;
+                }
+                for(int i=0; i<numCounters; ++i){
+                    if(i>0){
+                        fds[i]=open(configs[i], fds[0]);
+                    }
+                    if(fds[i]>=0){
+                        slot[i]=numOpen++;
+                    }
+                }
+                status="available";
+            #endif
+        }
+        PerfCounters(const PerfCounters&)=delete;
+        PerfCounters& operator=(const PerfCounters&)=delete;
+        ~PerfCounters(){
+            #ifdef __linux__
+                for(int i=numCounters-1; i>=0; --i){
+                    if(fds[i]>=0){
+                        close(fds[i]);
+                    }
+                }
+            #endif
+        }
+        bool available() const {
+            return numOpen>0;
+        }
+        const std::string& getStatus() const {
+            return status;
+        }
+        #ifdef __linux__
+            void reset(){
+                ioctl(fds[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+            }
+            void enable(){
+                ioctl(fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+            }
+            void disable(){
+                ioctl(fds[0], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+            }
+            /**Counts since the last reset; NaN for counters that are not open*/
+            void read(double* counts){
+                uint64_t buffer[1+numCounters]={0};
+                const bool ok=::read(fds[0], buffer, sizeof(buffer))>0;
+                for(int i=0; i<numCounters; ++i){
+                    counts[i]=ok&&slot[i]>=0?(double)buffer[1+slot[i]]:std::nan("");
+                }
+            }
+        #else
+            void reset(){}
+            void enable(){}
+            void disable(){}
+            void read(double* counts){
+                for(int i=0; i<numCounters; ++i){
+                    counts[i]=std::nan("");
+                }
+            }
+        #endif
+    };
+    //set in main unless counters are disabled or unavailable
+    PerfCounters* perfCounters=nullptr;
+
+    struct Result{
+        std::string name;
+        int populationSize;
+        int dimension;
+        int iterations;
+        double minNsPerCandidate;
+        double medianNsPerCandidate;
+        double allocationsPerIteration;
+        double countersPerCandidate[numCounters];
+        std::vector<double> nsPerCandidate;//every repetition, for statistical comparisons
+    };
+
+    /**Keeps the pinned core constant between runs so that timings are repeatable*/
+    bool pinToCore(int core){
+        #ifdef __linux__
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET(core, &set);
+            return sched_setaffinity(0, sizeof(set), &set)==0;
+        #else
+            return false;
+        #endif
+    }
+
+    /**A kernel that processes numCandidates candidates per call; setup
+    runs before every call and is excluded from the timings and allocation
+    counts*/
+    struct Case{
+        std::string name;
+        int populationSize;
+        int dimension;
+        int numCandidates;
+        std::function<void()> setup;
+        std::function<void()> kernel;
+    };
+
+    /**Calls setup and kernel iterations times; returns the nanoseconds spent
+    in kernel and adds its allocations to allocations*/
+    double timeIterations(const Case& c, int iterations, std::size_t* allocations){
+        double elapsed=0.0;
+        for(int i=0; i<iterations; ++i){
+            c.setup();
+            const std::size_t allocationsBefore=numAllocations;
+            const auto start=Clock::now();
+            c.kernel();
+            elapsed+=std::chrono::duration<double, std::nano>(Clock::now()-start).count();
+            *allocations+=numAllocations-allocationsBefore;
+        }
+        return elapsed;
+    }
+
+    /**Times every case.  The repetitions are interleaved, one repetition of
+    each case in turn, so that drift in the machine (frequency, thermal
+    state, other load) is spread over all cases instead of landing on
+    whichever ran at the time.*/
+    std::vector<Result> measure(const std::vector<Case>& cases){
+        std::vector<int> iterations(cases.size());
+        std::size_t ignored=0;
+        for(int k=0; k<cases.size(); ++k){
+            timeIterations(cases[k], numWarmup, &ignored);
+            //calibrate the number of iterations
+            int calibration=1;
+            while(true){
+                const double elapsed=timeIterations(cases[k], calibration, &ignored)*1e-9;
+                if(elapsed>=targetRepSeconds/4||calibration>=(1<<20)){
+                    iterations[k]=std::max(1, (int)(calibration*targetRepSeconds/std::max(elapsed, 1e-9)));
+                    break;
+                }
+                calibration*=2;
+            }
+        }
+        std::vector<std::vector<double> > nsPerCandidate(cases.size());
+        std::vector<std::size_t> allocations(cases.size(), 0);
+        for(int rep=0; rep<numReps; ++rep){
+            for(int k=0; k<cases.size(); ++k){
+                //one untimed call brings the case back into the caches
+                timeIterations(cases[k], 1, &ignored);
+                const double elapsed=timeIterations(cases[k], iterations[k], &allocations[k]);
+                nsPerCandidate[k].push_back(elapsed/((double)iterations[k]*cases[k].numCandidates));
+            }
+        }
+        std::vector<Result> results;
+        for(int k=0; k<cases.size(); ++k){
+            const Case& c=cases[k];
+            std::vector<double> sorted=nsPerCandidate[k];
+            std::sort(sorted.begin(), sorted.end());
+            Result result={
+                c.name, c.populationSize, c.dimension, iterations[k],
+                sorted.front(), sorted[numReps/2],
+                (double)allocations[k]/((double)iterations[k]*numReps)
+            };
+            for(int i=0; i<numCounters; ++i){
+                result.countersPerCandidate[i]=std::nan("");
+            }
+            //in the order they ran
+            result.nsPerCandidate=nsPerCandidate[k];
+            if(perfCounters){
+                perfCounters->reset();
+                for(int i=0; i<iterations[k]; ++i){
+                    c.setup();
+                    perfCounters->enable();
+                    c.kernel();
+                    perfCounters->disable();
+                }
+                perfCounters->read(result.countersPerCandidate);
+                for(int i=0; i<numCounters; ++i){
+                    result.countersPerCandidate[i]/=(double)iterations[k]*c.numCandidates;
+                }
+            }
+            results.push_back(result);
+        }
+        return results;
+    }
+
+    auto getBounds(int dimension){
+        std::vector<swarm_utils::upper_lower<double> > ul;
+        swarm_utils::upper_lower<double> bounds={-4.0, 4.0};
+        for(int i=0; i<dimension; ++i){
+            ul.push_back(bounds);
+        }
+        return ul;
+    }
+    //trivial objective so that the kernels dominate
+    double sphere(const std::vector<double>& params){
+        double result=0.0;
+        for(const auto& v:params){
+            result+=v*v;
+        }
+        return result;
+    }
+    //results the compiler must not optimize away, checked in main
+    double sink=0.0;
+
+    /**Populations and generator a sweep point's kernels work on; shared by
+    their cases, since the repetitions run long after the cases are made*/
+    struct KernelState{
+        std::vector<swarm_utils::upper_lower<double> > ul;
+        swarm_utils::RandomGenerator rng;
+        swarm_utils::Population start;
+        swarm_utils::Population nest;
+        swarm_utils::Population newNest;
+        std::vector<double> best;
+        KernelState(int n, int dimension):ul(getBounds(dimension)), rng(42){
+            start=cuckoo::getNewNest(ul, sphere, [&](){return rng.getNorm();}, n);
+            nest=start;
+            newNest=start;
+            cuckoo::sortNest(nest);
+            best=nest[0].first;
+        }
+    };
+
+    void addKernels(int n, int dimension, std::vector<Case>* cases){
+        const auto state=std::make_shared<KernelState>(n, dimension);
+        auto unifL=[state](){return state->rng.getUniform();};
+        auto normL=[state](){return state->rng.getNorm();};
+        auto reset=[state, n](){
+            //element wise assignment reuses the existing buffers
+            for(int i=0; i<n; ++i){
+                state->nest[i].first=state->start[i].first;
+                state->nest[i].second=state->start[i].second;
+            }
+        };
+        auto noSetup=[](){};
+        cases->push_back({"cuckoo::getCuckoos", n, dimension, n, noSetup, [state, unifL, normL](){
+            cuckoo::getCuckoos(&state->newNest, state->nest, state->best, sphere, state->ul, 1.5, unifL, normL);
+        }});
+        cases->push_back({"cuckoo::getBestNest", n, dimension, n, reset, [state](){
+            cuckoo::getBestNest(&state->nest, state->newNest);
+        }});
+        cases->push_back({"cuckoo::sortNest", n, dimension, n, reset, [state](){
+            cuckoo::sortNest(state->nest);
+        }});
+        cases->push_back({"cuckoo::emptyNests", n, dimension, n, reset, [state, normL](){
+            cuckoo::emptyNests(&state->nest, sphere, normL, state->ul, .25);
+        }});
+        cases->push_back({"firefly::getUpdate", n, dimension, n, reset, [state, normL, dimension](){
+            firefly::getUpdate(&state->nest, sphere, state->ul, firefly::beta, 1.0/sqrt(8.0*dimension), .25, normL);
+        }});
+        const int numPairs=1000;
+        cases->push_back({"firefly::getDistanceSq", n, dimension, numPairs, noSetup, [state, n](){
+            for(int i=0; i<numPairs; ++i){
+                sink+=firefly::getDistanceSq(state->start[i%n].first, state->start[(i*7+1)%n].first);
+            }
+        }});
+    }
+    void addGenerator(std::vector<Case>* cases){
+        const auto rng=std::make_shared<swarm_utils::RandomGenerator>(42);
+        const int numDraws=10000;
+        auto noSetup=[](){};
+        cases->push_back({"RandomGenerator::getNorm", 0, 0, numDraws, noSetup, [rng](){
+            for(int i=0; i<numDraws; ++i){
+                sink+=rng->getNorm();
+            }
+        }});
+        cases->push_back({"RandomGenerator::getUniform", 0, 0, numDraws, noSetup, [rng](){
+            for(int i=0; i<numDraws; ++i){
+                sink+=rng->getUniform();
+            }
+        }});
+        cases->push_back({"swarm_utils::getLevyFlight", 0, 0, numDraws, noSetup, [rng](){
+            for(int i=0; i<numDraws; ++i){
+                sink+=swarm_utils::getLevyFlight(0.0, .01, 1.5, rng->getUniform(), rng->getNorm());
+            }
+        }});
+    }
+    void writeJson(std::ostream& out, bool pinned, const std::string& counterStatus, const std::vector<Result>& results){
+        out<<"{\n  \"pinned\": "<<(pinned?"true":"false")<<",\n";
+        out<<"  \"counters\": \""<<counterStatus<<"\",\n";
+        out<<"  \"warmup\": "<<numWarmup<<",\n  \"repetitions\": "<<numReps<<",\n";
+        out<<"  \"benchmarks\": [\n";
+        for(int i=0; i<results.size(); ++i){
+            const Result& r=results[i];
+            out<<"    {\"name\": \""<<r.name<<"\", \"populationSize\": "<<r.populationSize
+                <<", \"dimension\": "<<r.dimension<<", \"iterations\": "<<r.iterations
+                <<", \"minNsPerCandidate\": "<<r.minNsPerCandidate
+                <<", \"medianNsPerCandidate\": "<<r.medianNsPerCandidate
+                <<", \"allocationsPerIteration\": "<<r.allocationsPerIteration;
+            for(int c=0; c<numCounters; ++c){
+                out<<", \""<<counterNames[c]<<"PerCandidate\": ";
+                if(std::isnan(r.countersPerCandidate[c])){
+                    out<<"null";
+                }
+                else{
+                    out<<r.countersPerCandidate[c];
+                }
+            }
+            out<<", \"nsPerCandidate\": [";
+            for(int rep=0; rep<r.nsPerCandidate.size(); ++rep){
+                out<<(rep>0?", ":"")<<r.nsPerCandidate[rep];
+            }
+            out<<"]";
+            out<<"}"
+                <<(i+1<results.size()?",":"")<<"\n";
+        }
+        out<<"  ]\n}\n";
+    }
+}
+
+int main(int argc, char** argv){
+    bool useCounters=true;
+    std::string outputPath;
+    for(int i=1; i<argc; ++i){
+        if(std::string(argv[i])=="--no-counters"){
+            useCounters=false;
+        }
+        else{
+            outputPath=argv[i];
+        }
+    }
+    const bool pinned=pinToCore(0);
+    //perf_event_open is not even attempted with --no-counters
+    std::unique_ptr<PerfCounters> counters;
+    std::string counterStatus="disabled";
+    if(useCounters){
+        counters.reset(new PerfCounters());
+        counterStatus=counters->getStatus();
+        if(counters->available()){
+            perfCounters=counters.get();
+        }
+    }
+    std::vector<Case> cases;
+    for(int n:{25, 100, 400}){
+        for(int dimension:{2, 10, 50}){
+            addKernels(n, dimension, &cases);
+        }
+    }
+    addGenerator(&cases);
+    const std::vector<Result> results=measure(cases);
+    if(std::isnan(sink)){
+        std::cerr<<sink;
+    }
+    if(!outputPath.empty()){
+        std::ofstream out(outputPath);
+        writeJson(out, pinned, counterStatus, results);
+    }
+    else{
+        writeJson(std::cout, pinned, counterStatus, results);
+    }
+    return 0;
+}
@@ -0,0 +1,94 @@
+#ifndef __SWARM_BOUNDARY_H__
+#define __SWARM_BOUNDARY_H__
+#include <cmath>
+#include <algorithm>
+#include "utils.h"
+
+namespace swarm_utils{
+    /**Boundary policies: policy(value, lower, upper, parent, norm) maps a new
+    parameter into [lower, upper].  parent is the value before the move and
+    norm a standard normal generator.  Apart from reinitialize, which has to
+    draw only for values that are out of range, they are written with
+    min/max, floor and selects so they compile without branches.*/
+    enum class Boundary{
+        clamp,
+        reflect,
+        wrap,
+        reinitialize,
+        midpoint
+    };
+
+    /**Onto the nearest face of the box (the original behaviour)*/
+    struct ClampBoundary{
+        template<typename Norm>
+        double operator()(double value, double lower, double upper, double parent, const Norm& norm) const {
+            return getTruncatedParameter(lower, upper, value);
+        }
+    };
+    /**Mirrored back into the box by the distance it overshot; clamped if it
+    overshot by more than the width*/
+    struct ReflectBoundary{
+        template<typename Norm>
+        double operator()(double value, double lower, double upper, double parent, const Norm& norm) const {
+            const double reflected=value+2*std::max(lower-value, 0.0)-2*std::max(value-upper, 0.0);
+            return std::min(std::max(reflected, lower), upper);
+        }
+    };
+    /**Toroidal: leaving through one face re-enters through the other.
+    Values in the box, including either face, are left alone; a box of zero
+    width maps everything onto its single point.*/
+    struct WrapBoundary{
+        template<typename Norm>
+        double operator()(double value, double lower, double upper, double parent, const Norm& norm) const {
+            const double width=upper-lower;
+            const double t=(value-lower)/width;
+            const double wrapped=std::min(lower+(t-std::floor(t))*width, upper);
+            const double clamped=std::min(std::max(value, lower), upper);
+            return value==clamped||!(width>0)?clamped:wrapped;
+        }
+    };
+    /**Uniform inside the box, from a normal draw through the normal cdf*/
+    struct ReinitializeBoundary{
+        template<typename Norm>
+        double operator()(double value, double lower, double upper, double parent, const Norm& norm) const {
+            if(value>=lower&&value<=upper){
+                return value;
+            }
+            const double unif=.5*std::erfc(-norm()/std::sqrt(2.0));
+            return lower+unif*(upper-lower);
+        }
+    };
+    /**Halfway between the parent and the face it crossed*/
+    struct MidpointBoundary{
+        template<typename Norm>
+        double operator()(double value, double lower, double upper, double parent, const Norm& norm) const {
+            const double clamped=std::min(std::max(value, lower), upper);
+            return value==clamped?value:.5*(parent+clamped);
+        }
+    };
+
+    /**Calls fn with the policy for boundary.  Used once per generation, so
+    the kernels are compiled for each policy instead of switching per
+    parameter.*/
+    template<typename Fn>
+    void withBoundary(Boundary boundary, const Fn& fn){
+        switch(boundary){
+            case Boundary::reflect:
+                fn(ReflectBoundary());
+                break;
+            case Boundary::wrap:
+                fn(WrapBoundary());
+                break;
+            case Boundary::reinitialize:
+                fn(ReinitializeBoundary());
+                break;
+            case Boundary::midpoint:
+                fn(MidpointBoundary());
+                break;
+            default:
+                fn(ClampBoundary());
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,93 @@
+#ifndef __SWARM_BUDGET_H__
+#define __SWARM_BUDGET_H__
+#include <vector>
+#include <utility>
+#include <limits>
+#include <chrono>
+#include <atomic>
+#include "progress.h"
+
+namespace swarm_utils{
+    /**Stop condition of the population updates that never stops them early;
+    the optimizers instead stop once their budget is exhausted, so no member
+    is moved or replaced by a point that was not evaluated*/
+    struct NeverStop{
+        bool operator()() const {
+            return false;
+        }
+    };
+
+    /**Counts objective evaluations and stops an optimization once a maximum
+    number of evaluations or a wall clock deadline is reached.  Every real
+    evaluation goes through evaluate, which also remembers the best point seen
+    so the best answer so far can be returned even if it was overwritten
+    in the population.  Once exhausted the objective is no longer called and
+    evaluate returns infinity, which never replaces an existing member.
+    Budgets of concurrent runs can also draw from a shared pool of evaluations.*/
+    class EvaluationBudget{
+    public:
+        typedef std::chrono::steady_clock Clock;
+    private:
+        long long maxEvaluations=std::numeric_limits<long long>::max();
+        long long numEvaluations=0;
+        Clock::time_point deadline;
+        bool hasDeadline=false;
+        bool isExhausted=false;
+        std::atomic<long long>* pool=nullptr;
+        const CancellationToken* cancellation=nullptr;
+        std::pair<std::vector<double>, double> bestSoFar={std::vector<double>(), std::numeric_limits<double>::infinity()};
+    public:
+        EvaluationBudget& withMaxEvaluations(long long maxEvaluations_){
+            maxEvaluations=maxEvaluations_;
+            isExhausted=numEvaluations>=maxEvaluations;
+            return *this;
+        }
+        EvaluationBudget& withDeadline(const Clock::time_point& deadline_){
+            deadline=deadline_;
+            hasDeadline=true;
+            return *this;
+        }
+        /**Each evaluation is also taken from pool, shared with other runs; a run
+        stops once the pool is empty.  Storing zero in the pool stops them all.*/
+        EvaluationBudget& withSharedPool(std::atomic<long long>* pool_){
+            pool=pool_;
+            return *this;
+        }
+        /**Stops as soon as the token is cancelled, checked before every evaluation*/
+        EvaluationBudget& withCancellation(const CancellationToken* cancellation_){
+            cancellation=cancellation_;
+            return *this;
+        }
+        /**Deadline relative to now*/
+        template<typename Duration>
+        EvaluationBudget& withTimeLimit(const Duration& limit){
+            return withDeadline(Clock::now()+std::chrono::duration_cast<Clock::duration>(limit));
+        }
+        template<typename Params, typename ObjFn>
+        double evaluate(const Params& params, const ObjFn& objFn){
+            if(isExhausted||(cancellation&&cancellation->isCancelled())||(hasDeadline&&Clock::now()>=deadline)||(pool&&pool->fetch_sub(1)<=0)){
+                isExhausted=true;
+                return std::numeric_limits<double>::infinity();
+            }
+            const double value=objFn(params);
+            isExhausted=++numEvaluations>=maxEvaluations;
+            if(value<bestSoFar.second){
+                bestSoFar.first.assign(params.begin(), params.end());
+                bestSoFar.second=value;
+            }
+            return value;
+        }
+        bool exhausted() const {
+            return isExhausted||(cancellation&&cancellation->isCancelled())||(pool&&pool->load()<=0);
+        }
+        long long evaluations() const {
+            return numEvaluations;
+        }
+        /**Best evaluated point; the value is infinity before any evaluation*/
+        const std::pair<std::vector<double>, double>& best() const {
+            return bestSoFar;
+        }
+    };
+}
+
+#endif
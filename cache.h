@@ -0,0 +1,154 @@
+#ifndef __SWARM_CACHE_H__
+#define __SWARM_CACHE_H__
+#include <vector>
+#include <unordered_map>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <algorithm>
+
+namespace swarm_utils{
+    /**Hashes a quantized parameter vector*/
+    struct QuantizedKeyHash{
+        std::size_t operator()(const std::vector<long long>& key) const {
+            std::size_t seed=key.size();
+            for(const auto& v:key){
+                seed^=std::hash<long long>()(v)+0x9e3779b97f4a7c15ull+(seed<<6)+(seed>>2);
+            }
+            return seed;
+        }
+    };
+    /**value/tolerance rounded to an integer.  llround is undefined when the
+    result does not fit, so the ratio is clamped to +-2^62 first; values that
+    far out share a key.  NaN gets a key of its own.*/
+    inline long long quantizeValue(double value, double tolerance){
+        const double limit=4611686018427387904.0;//2^62
+        const double ratio=value/tolerance;
+        if(std::isnan(ratio)){
+            return std::numeric_limits<long long>::min();
+        }
+        return std::llround(std::min(std::max(ratio, -limit), limit));
+    }
+    /**Writes the parameters quantized to multiples of tolerance into key*/
+    template<typename Params>
+    void quantize(const Params& params, double tolerance, std::vector<long long>* key){
+        key->resize(params.size());
+        for(int i=0; i<params.size(); ++i){
+            (*key)[i]=quantizeValue(params[i], tolerance);
+        }
+    }
+
+    /**Bounded cache of objective values keyed by parameters quantized to a
+    tolerance.  Parameters that round to the same multiple of the tolerance
+    share a result.  Once full, entries are evicted with the CLOCK algorithm
+    (second chance LRU approximation) so memory never exceeds capacity entries.*/
+    class EvaluationCache{
+    private:
+        struct Entry{
+            std::vector<long long> key;
+            double value;
+            bool referenced;
+        };
+        typedef std::unordered_map<std::vector<long long>, int, QuantizedKeyHash> Lookup;
+        std::vector<Entry> entries;
+        Lookup lookup;
+        std::vector<long long> scratch;
+        std::size_t capacity;
+        std::size_t hand=0;
+        double tolerance;
+        long long numHits=0;
+        long long numMisses=0;
+
+        /**Returns the slot to (re)use for a new entry*/
+        int getSlot(){
+            if(entries.size()<capacity){
+                entries.push_back(Entry());
+                return entries.size()-1;
+            }
+            while(entries[hand].referenced){
+                entries[hand].referenced=false;
+                hand=(hand+1)%capacity;
+            }
+            const int slot=hand;
+            lookup.erase(entries[slot].key);
+            hand=(hand+1)%capacity;
+            return slot;
+        }
+        /**Inserts value under the key currently held in scratch*/
+        void insertQuantized(double value){
+            auto it=lookup.find(scratch);
+            if(it!=lookup.end()){
+                entries[it->second].value=value;
+                entries[it->second].referenced=true;
+                return;
+            }
+            const int slot=getSlot();
+            entries[slot].key=scratch;
+            entries[slot].value=value;
+            entries[slot].referenced=false;
+            lookup.emplace(scratch, slot);
+        }
+    public:
+        EvaluationCache(std::size_t capacity_, double tolerance_):
+            capacity(capacity_>0?capacity_:1),
+            tolerance(tolerance_)
+        {
+            entries.reserve(capacity);
+            lookup.reserve(capacity);
+        }
+        /**Returns true and sets value if the parameters are cached*/
+        template<typename Params>
+        bool find(const Params& params, double* value){
+            quantize(params, tolerance, &scratch);
+            auto it=lookup.find(scratch);
+            if(it==lookup.end()){
+                return false;
+            }
+            entries[it->second].referenced=true;
+            *value=entries[it->second].value;
+            return true;
+        }
+        template<typename Params>
+        void insert(const Params& params, double value){
+            quantize(params, tolerance, &scratch);
+            insertQuantized(value);
+        }
+        /**Returns the cached value or calls objFn and caches the result*/
+        template<typename Params, typename ObjFn>
+        double evaluate(const Params& params, const ObjFn& objFn){
+            double value;
+            if(find(params, &value)){
+                ++numHits;
+                return value;
+            }
+            ++numMisses;
+            value=objFn(params);
+            insertQuantized(value);//scratch still holds the key from find
+            return value;
+        }
+        std::size_t size() const {
+            return lookup.size();
+        }
+        long long hits() const {
+            return numHits;
+        }
+        long long misses() const {
+            return numMisses;
+        }
+        double hitRate() const {
+            return numHits+numMisses>0?(double)numHits/(numHits+numMisses):0.0;
+        }
+    };
+
+    /**Wraps an objective so that it is evaluated through the cache.  The
+    result can be passed to cuckoo::optimize or firefly::optimize in place of
+    the objective; the cache must outlive the optimization.*/
+    template<typename ObjFn>
+    auto cacheObjective(const ObjFn& objFn, EvaluationCache* cache){
+        return [=](const auto& params){
+            return cache->evaluate(params, objFn);
+        };
+    }
+}
+
+#endif
@@ -0,0 +1,204 @@
+#ifndef __SWARM_CHECKPOINT_H__
+#define __SWARM_CHECKPOINT_H__
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <utility>
+#include <stdexcept>
+#include <unistd.h>
+
+namespace swarm_utils{
+    /**Everything needed to continue an optimization bit for bit: the ranked
+    population, the next iteration, the length of the schedule (getPA in
+    cuckoo), the current annealing factor (deltaT in firefly) and the state
+    of the RandomGenerator.*/
+    struct Checkpoint{
+        std::vector<std::pair<std::vector<double>, double> > population;
+        int64_t iteration=0;
+        int64_t totalMC=0;
+        double schedule=0.0;
+        std::string rngState;
+    };
+
+    /**Binary layout (native endianness):
+        8 byte magic "SWRMCKP1", int64 iteration, int64 totalMC, double schedule,
+        uint32 populationSize, uint32 numParams,
+        populationSize x (double params[numParams], double value),
+        uint32 rngStateLength, char rngState[rngStateLength]
+    The file is written next to path, flushed to disk and renamed over it, so
+    a crash mid write leaves the previous checkpoint intact.*/
+    inline bool writeCheckpoint(const std::string& path, const Checkpoint& checkpoint){
+        const std::string tmpPath=path+".tmp";
+        FILE* file=fopen(tmpPath.c_str(), "wb");
+        if(!file){
+            return false;
+        }
+        const uint32_t populationSize=checkpoint.population.size();
+        const uint32_t numParams=populationSize>0?checkpoint.population[0].first.size():0;
+        const uint32_t rngStateLength=checkpoint.rngState.size();
+        bool ok=fwrite("SWRMCKP1", 1, 8, file)==8;
+        ok=ok&&fwrite(&checkpoint.iteration, sizeof(int64_t), 1, file)==1;
+        ok=ok&&fwrite(&checkpoint.totalMC, sizeof(int64_t), 1, file)==1;
+        ok=ok&&fwrite(&checkpoint.schedule, sizeof(double), 1, file)==1;
+        ok=ok&&fwrite(&populationSize, sizeof(uint32_t), 1, file)==1;
+        ok=ok&&fwrite(&numParams, sizeof(uint32_t), 1, file)==1;
+        for(const auto& member:checkpoint.population){
+            ok=ok&&fwrite(member.first.data(), sizeof(double), numParams, file)==numParams;
+            ok=ok&&fwrite(&member.second, sizeof(double), 1, file)==1;
+        }
+        ok=ok&&fwrite(&rngStateLength, sizeof(uint32_t), 1, file)==1;
+        ok=ok&&fwrite(checkpoint.rngState.data(), 1, rngStateLength, file)==rngStateLength;
+        ok=ok&&fflush(file)==0&&fsync(fileno(file))==0;
+        ok=(fclose(file)==0)&&ok;
+        return ok&&rename(tmpPath.c_str(), path.c_str())==0;
+    }
+    /**Returns false if the file is missing, truncated or names an empty
+    population; the sizes in the header are checked against the length of
+    the file before anything is allocated.*/
+    inline bool readCheckpoint(const std::string& path, Checkpoint* checkpoint){
+        FILE* file=fopen(path.c_str(), "rb");
+        if(!file){
+            return false;
+        }
+        auto remaining=[&](){
+            const long position=ftell(file);
+            fseek(file, 0, SEEK_END);
+            const long end=ftell(file);
+            fseek(file, position, SEEK_SET);
+            return position<0||end<position?(uint64_t)0:(uint64_t)(end-position);
+        };
+        char magic[8];
+        uint32_t populationSize=0;
+        uint32_t numParams=0;
+        uint32_t rngStateLength=0;
+        bool ok=fread(magic, 1, 8, file)==8&&std::memcmp(magic, "SWRMCKP1", 8)==0;
+        ok=ok&&fread(&checkpoint->iteration, sizeof(int64_t), 1, file)==1;
+        ok=ok&&fread(&checkpoint->totalMC, sizeof(int64_t), 1, file)==1;
+        ok=ok&&fread(&checkpoint->schedule, sizeof(double), 1, file)==1;
+        ok=ok&&fread(&populationSize, sizeof(uint32_t), 1, file)==1;
+        ok=ok&&fread(&numParams, sizeof(uint32_t), 1, file)==1;
+        ok=ok&&populationSize>0&&(uint64_t)populationSize*(numParams+1ull)*sizeof(double)<=remaining();
+        if(ok){
+            checkpoint->population.resize(populationSize);
+            for(auto& member:checkpoint->population){
+                member.first.resize(numParams);
+                ok=ok&&fread(member.first.data(), sizeof(double), numParams, file)==numParams;
+                ok=ok&&fread(&member.second, sizeof(double), 1, file)==1;
+            }
+        }
+        ok=ok&&fread(&rngStateLength, sizeof(uint32_t), 1, file)==1;
+        ok=ok&&rngStateLength<=remaining();
+        if(ok){
+            checkpoint->rngState.resize(rngStateLength);
+            ok=fread(&checkpoint->rngState[0], 1, rngStateLength, file)==rngStateLength;
+        }
+        fclose(file);
+        return ok;
+    }
+
+    /**Throws std::invalid_argument unless the checkpoint holds a non empty
+    population of numParams parameters each; the optimizers call this before
+    continuing from it.*/
+    inline void checkCheckpoint(const Checkpoint& checkpoint, std::size_t numParams){
+        if(checkpoint.population.empty()){
+            throw std::invalid_argument("checkpoint: empty population");
+        }
+        for(const auto& member:checkpoint.population){
+            if(member.first.size()!=numParams){
+                throw std::invalid_argument("checkpoint: number of parameters does not match the bounds");
+            }
+        }
+    }
+
+    /**Writes checkpoints on a background thread.  submit copies the checkpoint
+    into a pending buffer and returns; the writer thread swaps it with its own
+    buffer and writes it to disk.  If the writer is still busy when the next
+    checkpoint arrives, the pending one is replaced so the optimization loop
+    never waits on the disk.*/
+    class CheckpointWriter{
+    private:
+        std::string path;
+        Checkpoint pending;
+        Checkpoint writing;
+        bool hasPending=false;
+        bool done=false;
+        std::mutex mutex;
+        std::condition_variable signal;
+        std::thread writer;
+
+        void run(){
+            std::unique_lock<std::mutex> lock(mutex);
+            while(true){
+                signal.wait(lock, [&](){return hasPending||done;});
+                if(!hasPending){
+                    return;
+                }
+                std::swap(pending, writing);
+                hasPending=false;
+                lock.unlock();
+                writeCheckpoint(path, writing);
+                lock.lock();
+            }
+        }
+    public:
+        CheckpointWriter(const std::string& path_):path(path_){
+            writer=std::thread([this](){run();});
+        }
+        CheckpointWriter(const CheckpointWriter&)=delete;
+        CheckpointWriter& operator=(const CheckpointWriter&)=delete;
+        /**Writes any pending checkpoint before returning*/
+        ~CheckpointWriter(){
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                done=true;
+            }
+            signal.notify_one();
+            writer.join();
+        }
+        template<typename Population>
+        void submit(const Population& population, int64_t iteration, int64_t totalMC, double schedule, const std::string& rngState){
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                //assignment reuses the buffers of the previous checkpoint
+                pending.population.resize(population.size());
+                for(int i=0; i<population.size(); ++i){
+                    pending.population[i].first.assign(population[i].first.begin(), population[i].first.end());
+                    pending.population[i].second=population[i].second;
+                }
+                pending.iteration=iteration;
+                pending.totalMC=totalMC;
+                pending.schedule=schedule;
+                pending.rngState=rngState;
+                hasPending=true;
+            }
+            signal.notify_one();
+        }
+    };
+
+    /**Steps a cuckoo::Optimizer or firefly::Optimizer to completion, submitting
+    a checkpoint every checkpointEvery iterations.  Throws
+    std::invalid_argument unless checkpointEvery is positive.*/
+    template<typename Optimizer>
+    void runWithCheckpoints(Optimizer* optimizer, const std::string& path, int checkpointEvery){
+        if(checkpointEvery<=0){
+            throw std::invalid_argument("runWithCheckpoints: checkpointEvery must be positive");
+        }
+        CheckpointWriter writer(path);
+        while(!optimizer->done()){
+            optimizer->step();
+            if(optimizer->iteration()%checkpointEvery==0){
+                writer.submit(
+                    optimizer->population(), optimizer->iteration(), optimizer->totalIterations(), 
+                    optimizer->schedule(), optimizer->generator().getState()
+                );
+            }
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,195 @@
+/**Compares outputs of bench and fails if a kernel got slower.
+
+A kernel has regressed when its minimum ns per candidate grew by more than
+threshold (default 10%) and a one sided Mann-Whitney U test over the
+repetitions says the slowdown is significant at level alpha (default .01)
+after a Holm correction over all the kernels compared.  Both are needed:
+the test alone flags tiny but consistent changes, the ratio alone flags
+noise.  The minimum is used because interference only ever adds time, so
+it is the most repeatable of the summaries; the correction keeps the
+chance of any false alarm in a run at alpha rather than alpha per kernel.
+Kernels missing from the baseline are reported but never fail.
+
+Either side can be a comma separated list of files, whose repetitions are
+pooled.  Timings drift between runs of the same binary, so runs of the
+baseline and the current build should alternate (make bench-check does)
+rather than comparing with a file recorded at another time.
+
+Usage: compare baseline.json[,...] current.json[,...] [threshold] [alpha]
+Exits with 1 if any kernel regressed, 2 if a file cannot be read.*/
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <tuple>
+#include <algorithm>
+#include <cstdlib>
+#include <cstdio>
+
+namespace {
+    typedef std::tuple<std::string, int, int> Key;//name, population size, dimension
+    typedef std::map<Key, std::vector<double> > Samples;
+
+    /**Value following "field": on a line written by bench*/
+    bool findField(const std::string& line, const std::string& field, std::string* value){
+        const std::string pattern="\""+field+"\": ";
+        const auto start=line.find(pattern);
+        if(start==std::string::npos){
+            return false;
+        }
+        *value=line.substr(start+pattern.size());
+        return true;
+    }
+    /**Adds the per repetition timings of every kernel to samples.  bench
+    writes one kernel per line, so this is not a general JSON parser.*/
+    bool readSamples(const std::string& path, Samples* samples){
+        std::ifstream in(path);
+        if(!in){
+            return false;
+        }
+        std::string line;
+        while(std::getline(in, line)){
+            std::string name, populationSize, dimension, timings;
+            if(!findField(line, "name", &name)||!findField(line, "populationSize", &populationSize)||
+                !findField(line, "dimension", &dimension)||!findField(line, "nsPerCandidate", &timings)){
+                continue;
+            }
+            name=name.substr(1, name.find('"', 1)-1);
+            std::vector<double>& values=(*samples)[Key(name, std::atoi(populationSize.c_str()), std::atoi(dimension.c_str()))];
+            std::stringstream list(timings.substr(1, timings.find(']')-1));
+            std::string value;
+            while(std::getline(list, value, ',')){
+                values.push_back(std::atof(value.c_str()));
+            }
+        }
+        return true;
+    }
+    /**Pools the samples of every file in the comma separated paths*/
+    bool readAllSamples(const std::string& paths, Samples* samples){
+        std::stringstream list(paths);
+        std::string path;
+        while(std::getline(list, path, ',')){
+            if(!readSamples(path, samples)){
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /**Holm's step down adjustment: the i-th smallest of m p-values is
+    multiplied by m-i (counting from 0) and the results made non decreasing,
+    so rejecting adjusted values below alpha bounds the family wise error
+    rate by alpha*/
+    std::vector<double> holmAdjust(const std::vector<double>& pValues){
+        const int m=pValues.size();
+        std::vector<int> order(m);
+        for(int i=0; i<m; ++i){
+            order[i]=i;
+        }
+        std::sort(order.begin(), order.end(), [&](int a, int b){
+            return pValues[a]<pValues[b];
+        });
+        std::vector<double> adjusted(m);
+        double largest=0.0;
+        for(int rank=0; rank<m; ++rank){
+            largest=std::max(largest, std::min(1.0, (m-rank)*pValues[order[rank]]));
+            adjusted[order[rank]]=largest;
+        }
+        return adjusted;
+    }
+
+    /**P(U>=observed U) when x and y come from the same distribution, where U
+    counts the pairs with x above y (ties count one half).  Exact: counts the
+    orderings of the pooled sample by their U, in half units to allow ties.*/
+    double mannWhitneyGreater(const std::vector<double>& x, const std::vector<double>& y){
+        const int n=x.size();
+        const int m=y.size();
+        int doubledU=0;
+        for(const auto& xi:x){
+            for(const auto& yj:y){
+                doubledU+=xi>yj?2:(xi==yj?1:0);
+            }
+        }
+        //counts[i][j][u]: orderings of i x's and j y's with U=u
+        const int maxU=n*m;
+        std::vector<std::vector<std::vector<double> > > counts(n+1, std::vector<std::vector<double> >(m+1, std::vector<double>(maxU+1, 0.0)));
+        for(int i=0; i<=n; ++i){
+            for(int j=0; j<=m; ++j){
+                if(i==0||j==0){
+                    counts[i][j][0]=1.0;
+                    continue;
+                }
+                for(int u=0; u<=maxU; ++u){
+                    //the largest value is either an x, above all j y's, or a y
+                    counts[i][j][u]=(u>=j?counts[i-1][j][u-j]:0.0)+counts[i][j-1][u];
+                }
+            }
+        }
+        double total=0.0;
+        double atLeast=0.0;
+        for(int u=0; u<=maxU; ++u){
+            total+=counts[n][m][u];
+            if(2*u>=doubledU){
+                atLeast+=counts[n][m][u];
+            }
+        }
+        return atLeast/total;
+    }
+}
+
+int main(int argc, char** argv){
+    if(argc<3){
+        std::cerr<<"usage: compare baseline.json[,...] current.json[,...] [threshold] [alpha]"<<std::endl;
+        return 2;
+    }
+    const double threshold=argc>3?std::atof(argv[3]):.1;
+    const double alpha=argc>4?std::atof(argv[4]):.01;
+    Samples baseline;
+    Samples current;
+    if(!readAllSamples(argv[1], &baseline)||!readAllSamples(argv[2], &current)){
+        std::cerr<<"unable to read "<<argv[1]<<" or "<<argv[2]<<std::endl;
+        return 2;
+    }
+    struct Comparison{
+        std::string label;
+        double before;
+        double after;
+        double p;
+    };
+    std::vector<Comparison> comparisons;
+    for(const auto& entry:current){
+        const Key& key=entry.first;
+        char label[128];
+        std::snprintf(label, sizeof(label), "%-30s n=%-4d d=%-3d", std::get<0>(key).c_str(), std::get<1>(key), std::get<2>(key));
+        const auto previous=baseline.find(key);
+        if(previous==baseline.end()||previous->second.empty()||entry.second.empty()){
+            std::cout<<label<<" not in baseline"<<std::endl;
+            continue;
+        }
+        comparisons.push_back({
+            label, 
+            *std::min_element(previous->second.begin(), previous->second.end()), 
+            *std::min_element(entry.second.begin(), entry.second.end()), 
+            mannWhitneyGreater(entry.second, previous->second)
+        });
+    }
+    std::vector<double> pValues;
+    for(const auto& c:comparisons){
+        pValues.push_back(c.p);
+    }
+    const std::vector<double> adjusted=holmAdjust(pValues);
+    int numRegressions=0;
+    for(int i=0; i<comparisons.size(); ++i){
+        const Comparison& c=comparisons[i];
+        const double change=c.after/c.before-1.0;
+        const bool regressed=change>threshold&&adjusted[i]<alpha;
+        numRegressions+=regressed;
+        char line[256];
+        std::snprintf(line, sizeof(line), "%s %10.2f -> %10.2f ns %+7.1f%%  p=%.4f%s", c.label.c_str(), c.before, c.after, 100*change, adjusted[i], regressed?"  REGRESSION":"");
+        std::cout<<line<<std::endl;
+    }
+    std::cout<<numRegressions<<" regression(s) beyond "<<100*threshold<<"% at alpha="<<alpha<<" (Holm adjusted over "<<comparisons.size()<<" kernels)"<<std::endl;
+    return numRegressions>0?1:0;
+}
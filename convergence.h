@@ -0,0 +1,121 @@
+#ifndef __SWARM_CONVERGENCE_H__
+#define __SWARM_CONVERGENCE_H__
+#include <vector>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+namespace swarm_utils{
+    /**Early stopping rules; each is disabled until set.  The spreads are
+    measured over the best eliteFraction of the ranked population, since cuckoo
+    search re-randomizes its worst nests every generation.*/
+    struct ConvergenceCriteria{
+        int window=0;
+        double minRelativeImprovement=0.0;
+        double minDiameter=-1.0;
+        double minFitnessSpread=-1.0;
+        double eliteFraction=.5;
+        /**Stop if the best value improved by less than minRelativeImprovement
+        (relative to its magnitude) over the last window generations*/
+        ConvergenceCriteria& withStagnation(int window_, double minRelativeImprovement_){
+            window=window_;
+            minRelativeImprovement=minRelativeImprovement_;
+            return *this;
+        }
+        /**Stop if the bounding box of the elite, with each parameter scaled by
+        upper-lower, has a diagonal below minDiameter*/
+        ConvergenceCriteria& withMinDiameter(double minDiameter_){
+            minDiameter=minDiameter_;
+            return *this;
+        }
+        /**Stop if worst minus best value of the elite is below minFitnessSpread*/
+        ConvergenceCriteria& withMinFitnessSpread(double minFitnessSpread_){
+            minFitnessSpread=minFitnessSpread_;
+            return *this;
+        }
+        ConvergenceCriteria& withEliteFraction(double eliteFraction_){
+            eliteFraction=eliteFraction_;
+            return *this;
+        }
+    };
+
+    enum class Convergence{
+        none,
+        stagnation,
+        diameter,
+        fitnessSpread
+    };
+
+    /**Tracks the criteria generation by generation.  The best values live in a
+    ring buffer so the stagnation test is O(1); the spreads take one pass over
+    the elite with no allocation after the first generation.*/
+    class ConvergenceMonitor{
+    private:
+        ConvergenceCriteria criteria;
+        std::vector<double> history;
+        std::vector<double> lower;
+        std::vector<double> upper;
+        int numRecorded=0;
+        Convergence reason=Convergence::none;
+
+        template<typename Population, typename Array>
+        double getDiameter(const Population& population, int numElite, const Array& ul){
+            const int numParams=population[0].first.size();
+            lower.assign(population[0].first.begin(), population[0].first.end());
+            upper.assign(population[0].first.begin(), population[0].first.end());
+            for(int i=1; i<numElite; ++i){
+                for(int k=0; k<numParams; ++k){
+                    const double v=population[i].first[k];
+                    lower[k]=v<lower[k]?v:lower[k];
+                    upper[k]=v>upper[k]?v:upper[k];
+                }
+            }
+            double diameterSq=0.0;
+            for(int k=0; k<numParams; ++k){
+                const double scaled=(upper[k]-lower[k])/(ul[k].upper-ul[k].lower);
+                diameterSq+=scaled*scaled;
+            }
+            return std::sqrt(diameterSq);
+        }
+    public:
+        ConvergenceMonitor(){}
+        ConvergenceMonitor(const ConvergenceCriteria& criteria_):criteria(criteria_){
+            history.resize(criteria.window>0?criteria.window+1:0);
+        }
+        /**Records a ranked population; returns true once converged*/
+        template<typename Population, typename Array>
+        bool update(const Population& population, const Array& ul){
+            if(reason!=Convergence::none){
+                return true;
+            }
+            const int numElite=std::max(1, std::min((int)population.size(), (int)std::ceil(criteria.eliteFraction*population.size())));
+            const double best=population[0].second;
+            if(criteria.window>0){
+                const int size=history.size();
+                history[numRecorded%size]=best;
+                ++numRecorded;
+                if(numRecorded>=size){
+                    const double previous=history[numRecorded%size];//oldest entry, window generations ago
+                    if(previous-best<=criteria.minRelativeImprovement*std::abs(previous)){
+                        reason=Convergence::stagnation;
+                    }
+                }
+            }
+            if(criteria.minFitnessSpread>=0&&population[numElite-1].second-best<criteria.minFitnessSpread){
+                reason=Convergence::fitnessSpread;
+            }
+            if(criteria.minDiameter>=0&&getDiameter(population, numElite, ul)<criteria.minDiameter){
+                reason=Convergence::diameter;
+            }
+            return reason!=Convergence::none;
+        }
+        bool converged() const {
+            return reason!=Convergence::none;
+        }
+        Convergence getReason() const {
+            return reason;
+        }
+    };
+}
+
+#endif
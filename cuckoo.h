@@ -2,9 +2,22 @@
 #define __CUCKOO__H__
 #include "FunctionalUtilities.h"
 #include <cstdlib> 
-#include "SimulateNorm.h"
 #include <tuple>
+#include <string>
+#include <stdexcept>
+#include <limits>
 #include "utils.h"
+#include "checkpoint.h"
+#include "budget.h"
+#include "convergence.h"
+#include "restart.h"
+#include "observer.h"
+#include "statistics.h"
+#include "boundary.h"
+#include "sampling.h"
+#include "opposition.h"
+#include "surrogate.h"
+#include "localsearch.h"
 
 /**Based off the following paper: http://www.airccse.org/journal/ijaia/papers/0711ijaia04.pdf*/
 namespace cuckoo{
@@ -15,11 +28,13 @@ namespace cuckoo{
             return val1.second<val2.second;//smallest to largest
         });
     }
-    template<typename Nest>
-    void getBestNest(Nest* nest, const Nest& newNest){
+    /**onReplace(i, previousValue, newValue) is called before nest i is replaced*/
+    template<typename Nest, typename OnReplace>
+    void getBestNest(Nest* nest, const Nest& newNest, const OnReplace& onReplace){
         Nest& nestRef= *nest;
         for(int i=0; i<nestRef.size(); ++i){
             if(newNest[i].second<=nestRef[i].second){
+                onReplace(i, nestRef[i].second, newNest[i].second);
                 nestRef[i].second=newNest[i].second;//replace previous function result with current
                 nestRef[i].first=newNest[i].first; //replace previous parameters with current
             }
@@ -27,15 +42,31 @@ namespace cuckoo{
         sortNest(nestRef);
  
     }
+    template<typename Nest>
+    void getBestNest(Nest* nest, const Nest& newNest){
+        getBestNest(nest, newNest, [](const auto& i, const auto& previousValue, const auto& newValue){});
+    }
     template<typename Parm>
     auto getStepSize(const Parm& curr, const Parm& best, const Parm& lower, const Parm& upper){
         return .01*(upper-lower)*(curr-best);//.01 comes from matlab code
     }
 
+    template<typename Levy>
+    const Levy& getLevyPolicy(const Levy& levy){
+        return levy;
+    }
+    /**A plain lambda selects the original power law step*/
+    inline swarm_utils::PowerLawLevy getLevyPolicy(double lambda){
+        return swarm_utils::PowerLawLevy(lambda);
+    }
+
+    /**lambda is either the Levy index or a step policy such as
+    swarm_utils::MantegnaLevy.  boundary maps steps that leave the box back
+    into it, see boundary.h.*/
     template<
         typename Nest,  typename Array, typename ObjFun,
         typename U, typename Norm, typename Unif,
-        typename BestParameter
+        typename BestParameter, typename Boundary=swarm_utils::ClampBoundary
     >
     void getCuckoos(
         Nest* newNest, const Nest& nest, 
@@ -44,20 +75,54 @@ namespace cuckoo{
         const Array& ul, 
         const U& lambda, 
         const Unif& unif,
-        const Norm& norm
+        const Norm& norm,
+        const Boundary& boundary=Boundary()
     ){
         int n=nest.size(); //num nests
         int m=nest[0].first.size(); //num parameters
         Nest& nestRef= *newNest;
+        const auto& levy=getLevyPolicy(lambda);
         for(int i=0; i<n;++i){
             for(int j=0; j<m; ++j){
-                nestRef[i].first[j]=swarm_utils::getTruncatedParameter(
-                    ul[j].lower, ul[j].upper, 
-                    swarm_utils::getLevyFlight(
+                nestRef[i].first[j]=boundary(
+                    levy(
                         nest[i].first[j], 
                         getStepSize(nest[i].first[j], bP[j], ul[j].lower, ul[j].upper), 
-                        lambda, unif(), norm()
-                    )
+                        unif, norm
+                    ),
+                    ul[j].lower, ul[j].upper, nest[i].first[j], norm
+                );
+            }
+            nestRef[i].second=objFun(nestRef[i].first);
+        }
+    }
+    /**getCuckoos with a step scale (the .01 of getStepSize) and Levy index
+    for each nest.  Levy is constructed from the nest's index.*/
+    template<
+        typename Levy, typename Nest, typename Array, typename ObjFun,
+        typename Norm, typename Unif, typename BestParameter, typename Boundary
+    >
+    void getAdaptiveCuckoos(
+        Nest* newNest, const Nest& nest,
+        const BestParameter& bP,
+        const ObjFun& objFun,
+        const Array& ul,
+        const std::vector<double>& scales,
+        const std::vector<double>& lambdas,
+        const Unif& unif,
+        const Norm& norm,
+        const Boundary& boundary
+    ){
+        int n=nest.size();
+        int m=nest[0].first.size();
+        Nest& nestRef= *newNest;
+        for(int i=0; i<n;++i){
+            const Levy levy(lambdas[i]);
+            for(int j=0; j<m; ++j){
+                const double curr=nest[i].first[j];
+                nestRef[i].first[j]=boundary(
+                    levy(curr, scales[i]*(ul[j].upper-ul[j].lower)*(curr-bP[j]), unif, norm),
+                    ul[j].lower, ul[j].upper, curr, norm
                 );
             }
             nestRef[i].second=objFun(nestRef[i].first);
@@ -65,7 +130,7 @@ namespace cuckoo{
     }
 
 
-    
+
     template<typename Array, typename ObjFn, typename Rand>
     auto getNewNest(const Array& ul, const ObjFn& objFn, const Rand& rnd, int n){
         return futilities::for_each(0, n, [&](const auto& index){
@@ -78,68 +143,670 @@ namespace cuckoo{
         return pMax-(pMax-pMin)*index/n;
     }
 
-    template<typename Nest, typename ObjFn, typename P, typename Array, typename Rand>
-    void emptyNests(Nest* newNest, const ObjFn& objFn, const Rand& rnd, const Array& ul, const P& p){
+    /**onAbandon(i) is called before nest i is re-randomized.  Stops
+    abandoning nests as soon as stop() is true.*/
+    template<
+        typename Nest, typename ObjFn, typename P, typename Array, typename Rand, typename OnAbandon, 
+        typename Stop=swarm_utils::NeverStop
+    >
+    void emptyNests(
+        Nest* newNest, const ObjFn& objFn, const Rand& rnd, const Array& ul, const P& p, const OnAbandon& onAbandon,
+        const Stop& stop=Stop()
+    ){
         Nest& nestRef= *newNest;
         int n=nestRef.size();
         int numToKeep=(int)(p*nestRef.size());
         int startNum=n-numToKeep;
-        for(int i=startNum; i<n; ++i){
+        for(int i=startNum; i<n&&!stop(); ++i){
+            onAbandon(i);
             nestRef[i]=swarm_utils::getNewParameterAndFn(ul, objFn, rnd);
         }
     }
+    template<typename Nest, typename ObjFn, typename P, typename Array, typename Rand>
+    void emptyNests(Nest* newNest, const ObjFn& objFn, const Rand& rnd, const Array& ul, const P& p){
+        emptyNests(newNest, objFn, rnd, ul, p, [](const auto& i){});
+    }
 
-    template< typename Array, typename ObjFn>
-    auto optimize(const ObjFn& objFn, const Array& ul, int n, int totalMC, double tol, int seed){
-        int numParams=ul.size();
-        srand(seed);
-        SimulateNorm norm(seed);
-        auto unifL=[](){return swarm_utils::getUniform();};
-        auto normL=[&](){return norm.getNorm();};
-        auto nest=getNewNest(ul, objFn,normL, n);
-        double lambda=1.5;
+    /**How nests are abandoned: the worst are replaced by random points
+    (emptyNests), or every nest tries a biased random walk (discoverNests)*/
+    enum class Discovery{
+        random,
+        differential
+    };
+
+    /**Discovery step of Yang and Deb's reference code: every nest gets a
+    candidate moved by r*(nest[j]-nest[k]), with r uniform and j, k random
+    nests, in each parameter with probability 1-p (rand>pa in the
+    reference).  The steps follow the spread of the population instead of
+    covering the whole box.  A candidate that did not move, for example
+    because j==k, is not evaluated; one that moved and is no worse replaces
+    its nest, and onAbandon(i) is called first.  scratch must have the
+    shape of nest and is overwritten.*/
+    template<typename Nest, typename ObjFn, typename P, typename Array, typename Unif, typename Norm, typename Boundary, typename OnAbandon>
+    void discoverNests(
+        Nest* nest, Nest* scratch, const ObjFn& objFn, const Unif& unif, const Norm& norm, const Array& ul, const P& p, 
+        const Boundary& boundary, const OnAbandon& onAbandon
+    ){
+        Nest& nestRef= *nest;
+        Nest& candidates= *scratch;
+        const int n=nestRef.size();
+        const int m=nestRef[0].first.size();
+        for(int i=0; i<n; ++i){
+            const int j=std::min(n-1, (int)(unif()*n));
+            const int k=std::min(n-1, (int)(unif()*n));
+            const double r=unif();
+            bool moved=false;
+            for(int l=0; l<m; ++l){
+                const double parent=nestRef[i].first[l];
+                const double step=unif()>p?r*(nestRef[j].first[l]-nestRef[k].first[l]):0.0;
+                candidates[i].first[l]=boundary(parent+step, ul[l].lower, ul[l].upper, parent, norm);
+                moved=moved||candidates[i].first[l]!=parent;
+            }
+            //an unmoved candidate would only cost an evaluation to find its nest again
+            candidates[i].second=moved?objFn(candidates[i].first):std::numeric_limits<double>::infinity();
+        }
+        for(int i=0; i<n; ++i){
+            if(candidates[i].second<=nestRef[i].second){
+                onAbandon(i);
+                std::swap(nestRef[i], candidates[i]);
+            }
+        }
+    }
+
+    /**Success history adaptation of the step scale, the Levy index and the
+    discovery rate, after JADE (Zhang and Sanderson, 2009).  Every generation
+    each nest draws its own scale, log normal around meanScale, and index,
+    normal around meanLambda; the means move towards the values whose cuckoos
+    replaced their nest.  The discovery rate is drawn once per generation
+    around meanPA and the mean moves towards it when abandonment improved a
+    nest.  Sampling and updates are O(n) per generation.*/
+    struct Adaptation{
+        double meanScale=.01;
+        double meanLambda=1.5;
+        double meanPA=.25;
+        /**Weight of the latest generation in the means*/
+        double learningRate=.1;
+        double minLambda=1.1;
+        double maxLambda=1.9;
+        double minPA=.05;
+        double maxPA=.5;
+        std::vector<double> scales;
+        std::vector<double> lambdas;
+        double pa=.25;
+        /**Draws the parameters of the next generation*/
+        template<typename Norm>
+        void sample(int n, const Norm& norm){
+            scales.resize(n);
+            lambdas.resize(n);
+            for(int i=0; i<n; ++i){
+                scales[i]=meanScale*std::exp(.5*norm());
+                lambdas[i]=std::min(std::max(meanLambda+.1*norm(), minLambda), maxLambda);
+            }
+            pa=std::min(std::max(meanPA+.1*norm(), minPA), maxPA);
+            sumLogScale=0.0;
+            sumLambda=0.0;
+            sumWeights=0.0;
+        }
+        /**The cuckoo of nest i improved on it by improvement; as in SHADE,
+        larger improvements weigh more*/
+        void recordSuccess(int i, double improvement){
+            sumLogScale+=improvement*std::log(scales[i]);
+            sumLambda+=improvement*lambdas[i];
+            sumWeights+=improvement;
+        }
+        /**Moves the means.  The scale moves on a log scale, so that without
+        selection it does not drift.*/
+        void update(bool abandonmentImproved){
+            if(sumWeights>0){
+                meanScale=std::exp((1-learningRate)*std::log(meanScale)+learningRate*sumLogScale/sumWeights);
+                meanLambda=(1-learningRate)*meanLambda+learningRate*sumLambda/sumWeights;
+            }
+            if(abandonmentImproved){
+                meanPA=(1-learningRate)*meanPA+learningRate*pa;
+            }
+        }
+    private:
+        double sumLogScale=0.0;
+        double sumLambda=0.0;
+        double sumWeights=0.0;
+    };
+
+    /**Cuckoo search as an object that advances one generation per call to step,
+    so that many optimizations can be interleaved on a single thread.  Observer
+    receives the hooks of swarm_utils::NullObserver; it is held by value, or by
+    reference if Observer is a reference type.  Levy is the step policy,
+    swarm_utils::PowerLawLevy or swarm_utils::MantegnaLevy.*/
+    template<typename ObjFn, typename Array, typename Observer=swarm_utils::NullObserver, typename Levy=swarm_utils::PowerLawLevy>
+    class Optimizer{
+    private:
+        ObjFn objFn;
+        Array ul;
+        swarm_utils::Population nest;
+        swarm_utils::Population newNest;
+        swarm_utils::RandomGenerator rng;
+        swarm_utils::EvaluationBudget budget;
+        swarm_utils::ConvergenceMonitor monitor;
+        swarm_utils::Progress* progress=nullptr;
+        Observer observer;
+        swarm_utils::RunStatistics stats;
+        int i;
+        int totalMC;
+        double tol;
+        Levy levy=Levy(1.5);
+        swarm_utils::Boundary boundary=swarm_utils::Boundary::clamp;
+        Discovery discovery=Discovery::random;
         double pMin=.05;
         double pMax=.5;
-        
-        double fMin=2;
-        int i=0;
-
-        sortNest(nest);
-        auto newNest=getNewNest(ul, objFn,normL, n);
-       
-       
-        while(i<totalMC&&fMin>tol){
+        double jumpingRate=0.0;
+        bool adaptive=false;
+        Adaptation adaptation;
+        std::vector<double> previousValues;
+        swarm_utils::LocalRefinement refinement;
+        double lastBest=std::numeric_limits<double>::infinity();
+        int sinceImprovement=0;
+        int surrogateSize=0;
+        swarm_utils::RbfSurrogate surrogate;
+        double predictionErrorSq=0.0;
+        std::vector<double> predictions;
+        std::vector<int> order;
+        /**All evaluations go through the budget*/
+        auto getObjective(){
+            return [this](const auto& params){
+                const uint64_t start=swarm_utils::readTicks();
+                const double value=budget.evaluate(params, objFn);
+                const uint64_t end=swarm_utils::readTicks();
+                stats.evaluationTicks+=end-start;
+                if(surrogateSize>0){
+                    surrogate.add(params, value);
+                    stats.surrogateTicks+=swarm_utils::readTicks()-end;
+                }
+                observer.onEvaluation(params, value);
+                return value;
+            };
+        }
+        /**Replaces nest[0] by the result of a Nelder-Mead search from it,
+        if better; the nest stays sorted*/
+        template<typename Objective>
+        void refine(const Objective& objective){
+            const long long evaluations=budget.evaluations();
+            const uint64_t evaluationTicks=stats.evaluationTicks;
+            const uint64_t start=swarm_utils::readTicks();
+            auto refined=swarm_utils::nelderMead(
+                nest[0].first, nest[0].second, ul, objective, 
+                refinement.maxEvaluations, refinement.initialStep, tol
+            );
+            if(refined.second<nest[0].second){
+                observer.onReplacement(0, nest[0].second, refined.second);
+                nest[0]=std::move(refined);
+                lastBest=nest[0].second;
+            }
+            stats.refinementEvaluations+=budget.evaluations()-evaluations;
+            stats.refinementTicks+=swarm_utils::readTicks()-start-(stats.evaluationTicks-evaluationTicks);
+        }
+        /**Evaluates the cuckoos in newNest, most promising first, except
+        those the surrogate predicts to be worse than their nest by more than
+        its recent error; these get an infinite value so getBestNest keeps
+        the nest.  The best fifth are always evaluated so the archive and the
+        error estimate keep up with the population.*/
+        template<typename Objective>
+        void screenCuckoos(const Objective& objective){
+            const int n=nest.size();
+            const uint64_t start=swarm_utils::readTicks();
+            const bool ready=surrogate.fit();
+            predictions.resize(n);
+            order.resize(n);
+            for(int j=0; j<n; ++j){
+                predictions[j]=ready?surrogate.predict(newNest[j].first):-std::numeric_limits<double>::infinity();
+                order[j]=j;
+            }
+            std::sort(order.begin(), order.end(), [&](int a, int b){
+                return predictions[a]-nest[a].second<predictions[b]-nest[b].second;
+            });
+            const double margin=std::sqrt(predictionErrorSq);
+            const int numAlwaysEvaluated=std::max(1, n/5);
+            stats.surrogateTicks+=swarm_utils::readTicks()-start;
+            for(int rank=0; rank<n; ++rank){
+                const int j=order[rank];
+                if(rank>=numAlwaysEvaluated&&predictions[j]>nest[j].second+margin){
+                    newNest[j].second=std::numeric_limits<double>::infinity();
+                    ++stats.screenedEvaluations;
+                    continue;
+                }
+                newNest[j].second=objective(newNest[j].first);
+                if(ready&&std::isfinite(newNest[j].second)){
+                    const double error=predictions[j]-newNest[j].second;
+                    predictionErrorSq=.9*predictionErrorSq+.1*error*error;
+                }
+            }
+        }
+    public:
+        /**The starting nest is initialize(objective, unif, norm) using the
+        optimizer's generator and budget*/
+        template<typename Initialize>
+        Optimizer(
+            const ObjFn& objFn_, const Array& ul_, int totalMC_, double tol_, int seed, 
+            const Initialize& initialize, const swarm_utils::EvaluationBudget& budget_=swarm_utils::EvaluationBudget(),
+            Observer observer_=Observer()
+        ):
+            objFn(objFn_), ul(ul_), rng(seed), budget(budget_), observer(observer_), i(0), totalMC(totalMC_), tol(tol_)
+        {
+            auto unifL=[&](){return rng.getUniform();};
+            auto normL=[&](){return rng.getNorm();};
+            nest=initialize(getObjective(), unifL, normL);
+            sortNest(nest);
+            newNest=nest;//completely overwritten by getCuckoos
+        }
+        /**Continues from a checkpoint*/
+        Optimizer(
+            const ObjFn& objFn_, const Array& ul_, const swarm_utils::Checkpoint& checkpoint, double tol_, 
+            const swarm_utils::EvaluationBudget& budget_=swarm_utils::EvaluationBudget(), 
+            Observer observer_=Observer()
+        ):
+            objFn(objFn_), ul(ul_), nest(checkpoint.population), newNest(checkpoint.population), rng(0), budget(budget_), observer(observer_),
+            i(checkpoint.iteration), totalMC(checkpoint.totalMC), tol(tol_)
+        {
+            swarm_utils::checkCheckpoint(checkpoint, ul.size());
+            if(!rng.setState(checkpoint.rngState)){
+                throw std::invalid_argument("checkpoint: corrupt random generator state");
+            }
+        }
+        bool done() const {
+            return i>=totalMC||nest[0].second<=tol||budget.exhausted()||monitor.converged();
+        }
+        /**Adds early stopping rules; call before the first step*/
+        void setConvergence(const swarm_utils::ConvergenceCriteria& criteria){
+            monitor=swarm_utils::ConvergenceMonitor(criteria);
+        }
+        /**How abandoned nests are replaced; random by default*/
+        void setDiscovery(Discovery discovery_){
+            discovery=discovery_;
+        }
+        /**Adapts the step scale, Levy index and discovery rate from the
+        success of each generation instead of using .01, 1.5 and getPA.  The
+        adaptation state is not part of a checkpoint; a resumed run starts
+        from the initial means.*/
+        void setAdaptive(bool adaptive_){
+            adaptive=adaptive_;
+        }
+        /**Current means of the adaptation; the initial values until
+        setAdaptive(true)*/
+        const Adaptation& adaptationState() const {
+            return adaptation;
+        }
+        /**After each generation, with probability rate, evaluates the
+        opposites of the nests within the box they span and keeps the best
+        (generation jumping, see opposition.h).  0, the default, never jumps;
+        Rahnamayan et al. suggest .3.*/
+        void setOppositionJumping(double rate){
+            jumpingRate=rate;
+        }
+        /**Hybrid mode: polishes the best nest with a bounded Nelder-Mead
+        search (localsearch.h) on the schedule of refinement.  Its
+        evaluations go through the same budget and objective, so they count
+        against the budget and hit any cache.  Disabled by default.*/
+        void setLocalRefinement(const swarm_utils::LocalRefinement& refinement_){
+            refinement=refinement_;
+        }
+        /**Pre-screens cuckoos with a cubic RBF surrogate (surrogate.h) fit
+        to the last archiveSize evaluations, so that cuckoos which clearly
+        will not beat their nest are not evaluated.  Worth it when the
+        objective costs much more than the fit, O(archiveSize^3) per
+        generation; see statistics() for the evaluations saved and the time
+        spent.  0, the default, evaluates every cuckoo.*/
+        void setSurrogate(int archiveSize){
+            surrogateSize=archiveSize;
+            surrogate=swarm_utils::RbfSurrogate(std::max(archiveSize, 1));
+            predictionErrorSq=0.0;
+            if(archiveSize>0){
+                for(const auto& member:nest){
+                    surrogate.add(member.first, member.second);
+                }
+            }
+        }
+        /**How cuckoos that leave the box are brought back; clamp by default*/
+        void setBoundary(swarm_utils::Boundary boundary_){
+            boundary=boundary_;
+        }
+        /**Publishes the iteration, evaluations and best point after every
+        generation for other threads to read*/
+        void setProgress(swarm_utils::Progress* progress_){
+            progress=progress_;
+        }
+        /**Which early stopping rule ended the run, if any*/
+        swarm_utils::Convergence convergence() const {
+            return monitor.getReason();
+        }
+        /**Runs one generation; does nothing once done.  Returns false when done.*/
+        bool step(){
+            if(done()){
+                return false;
+            }
+            auto unifL=[&](){return rng.getUniform();};
+            auto normL=[&](){return rng.getNorm();};
+            auto objective=getObjective();
+            observer.onGenerationStart(i, nest);
+            //phase timers exclude the objective, which is timed separately
+            uint64_t evaluationTicks=stats.evaluationTicks;
+            uint64_t start=swarm_utils::readTicks();
+            if(adaptive){
+                adaptation.sample(nest.size(), normL);
+            }
             /**Completely overwrites newNest*/
             //newNest now has the previous values from nest with levy flights added
-            getCuckoos(
-                &newNest, 
-                nest, nest[0].first, //the current best nest
-                objFn, ul, 
-                lambda, 
-                unifL, 
-                normL
-            );
+            auto generate=[&](const auto& evaluate){
+                swarm_utils::withBoundary(boundary, [&](const auto& policy){
+                    if(adaptive){
+                        getAdaptiveCuckoos<Levy>(
+                            &newNest, nest, nest[0].first, evaluate, ul,
+                            adaptation.scales, adaptation.lambdas, unifL, normL, policy
+                        );
+                        return;
+                    }
+                    getCuckoos(
+                        &newNest, 
+                        nest, nest[0].first, //the current best nest
+                        evaluate, ul, 
+                        levy, 
+                        unifL, 
+                        normL,
+                        policy
+                    );
+                });
+            };
+            uint64_t end;
+            if(surrogateSize>0){
+                //positions only; screenCuckoos decides which to evaluate
+                generate([](const auto& params){return 0.0;});
+                end=swarm_utils::readTicks();
+                stats.generationTicks+=end-start;
+                screenCuckoos(objective);
+                end=swarm_utils::readTicks();
+            }
+            else{
+                generate(objective);
+                end=swarm_utils::readTicks();
+                stats.generationTicks+=end-start-(stats.evaluationTicks-evaluationTicks);
+            }
             //compare previous nests with cuckoo nests and sort results
             //nest now has the best of nest and newNest
             getBestNest(
                 &nest, 
-                newNest
+                newNest,
+                [&](int index, double previousValue, double newValue){
+                    stats.improvingReplacements+=newValue<previousValue;
+                    if(adaptive&&newValue<previousValue){
+                        adaptation.recordSuccess(index, previousValue-newValue);
+                    }
+                    observer.onReplacement(index, previousValue, newValue);
+                }
             );
+            start=swarm_utils::readTicks();
+            stats.sortTicks+=start-end;
+            evaluationTicks=stats.evaluationTicks;
             //remove bottom "p" nests and resimulate.
-            emptyNests(&nest, objFn, normL, ul, getPA(pMin, pMax, i, totalMC));
+            auto onAbandon=[&](int index){
+                observer.onAbandonment(index);
+            };
+            const double pa=adaptive?adaptation.pa:getPA(pMin, pMax, i, totalMC);
+            if(adaptive){
+                previousValues.resize(nest.size());
+                for(int j=0; j<nest.size(); ++j){
+                    previousValues[j]=nest[j].second;
+                }
+            }
+            if(discovery==Discovery::differential){
+                swarm_utils::withBoundary(boundary, [&](const auto& policy){
+                    discoverNests(&nest, &newNest, objective, unifL, normL, ul, pa, policy, onAbandon);
+                });
+            }
+            else{
+                emptyNests(&nest, objective, normL, ul, pa, onAbandon, [&](){return budget.exhausted();});
+            }
+            if(adaptive){
+                //both kinds of discovery keep the nests in place until sorted
+                bool improved=false;
+                for(int j=0; j<nest.size(); ++j){
+                    improved=improved||nest[j].second<previousValues[j];
+                }
+                adaptation.update(improved);
+            }
+            end=swarm_utils::readTicks();
+            stats.abandonmentTicks+=end-start-(stats.evaluationTicks-evaluationTicks);
             sortNest(nest);
-            fMin=nest[0].second;
-
-            #ifdef VERBOSE_FLAG
-                std::cout<<"Index: "<<i<<", Param Vals: ";
-                for(auto& v:nest[0].first){
-                    std::cout<<v<<", ";
+            start=swarm_utils::readTicks();
+            stats.sortTicks+=start-end;
+            if(jumpingRate>0&&rng.getUniform()<=jumpingRate){
+                //newNest is overwritten by getCuckoos, so it can hold the opposites
+                evaluationTicks=stats.evaluationTicks;
+                swarm_utils::jumpToOpposites(&nest, &newNest, objective);
+                stats.generationTicks+=swarm_utils::readTicks()-start-(stats.evaluationTicks-evaluationTicks);
+            }
+            if(refinement.enabled()){
+                sinceImprovement=nest[0].second<lastBest?0:sinceImprovement+1;
+                lastBest=std::min(lastBest, nest[0].second);
+                const bool periodic=refinement.period>0&&(i+1)%refinement.period==0;
+                const bool stagnated=refinement.stagnation>0&&sinceImprovement>=refinement.stagnation;
+                if((periodic||stagnated)&&!budget.exhausted()){
+                    refine(objective);
+                    sinceImprovement=0;
                 }
-                std::cout<<", Obj Val: "<<fMin<<std::endl;
-            #endif
+            }
+            observer.onGenerationEnd(i, nest);
+            monitor.update(nest, ul);
             ++i;
+            if(progress){
+                progress->publish(i, budget.evaluations(), best());
+            }
+            return !done();
+        }
+        /**Best point found so far, which may already have left the nest if the
+        budget ran out mid generation*/
+        const std::pair<std::vector<double>, double>& best() const {
+            return budget.best().second<nest[0].second?budget.best():nest[0];
+        }
+        /**Counters and phase timers since construction (or since resuming
+        from a checkpoint)*/
+        swarm_utils::RunStatistics statistics() const {
+            swarm_utils::RunStatistics current=stats;
+            current.iterations=i;
+            current.evaluations=budget.evaluations();
+            return current;
+        }
+        swarm_utils::OptimizeResult result() const {
+            return swarm_utils::OptimizeResult(best(), statistics());
+        }
+        /**Ranked from best to worst*/
+        const swarm_utils::Population& population() const {
+            return nest;
+        }
+        int iteration() const {
+            return i;
+        }
+        long long evaluations() const {
+            return budget.evaluations();
+        }
+        int totalIterations() const {
+            return totalMC;
+        }
+        /**Position in the annealing schedule; getPA only depends on the iteration*/
+        double schedule() const {
+            return 0.0;
+        }
+        const swarm_utils::RandomGenerator& generator() const {
+            return rng;
+        }
+    };
+
+    /**makeOptimizer<swarm_utils::MantegnaLevy>(...) selects Mantegna steps*/
+    template<typename Levy=swarm_utils::PowerLawLevy, typename Array, typename ObjFn>
+    auto makeOptimizer(
+        const ObjFn& objFn, const Array& ul, int n, int totalMC, double tol, int seed, 
+        const swarm_utils::EvaluationBudget& budget=swarm_utils::EvaluationBudget()
+    ){
+        return Optimizer<ObjFn, Array, swarm_utils::NullObserver, Levy>(objFn, ul, totalMC, tol, seed, [&](const auto& objective, const auto& unifL, const auto& normL){
+            return getNewNest(ul, objective, normL, n);
+        }, budget);
+    }
+    /**Warm start from an existing population, for example the result of a
+    previous run.  The objective values in nest are trusted; if the objective
+    has changed, use makeOptimizerFromSeeds instead.*/
+    template< typename Array, typename ObjFn>
+    auto makeOptimizerFromPopulation(
+        const ObjFn& objFn, const Array& ul, const swarm_utils::Population& nest, int totalMC, double tol, int seed, 
+        const swarm_utils::EvaluationBudget& budget=swarm_utils::EvaluationBudget()
+    ){
+        return Optimizer<ObjFn, Array>(objFn, ul, totalMC, tol, seed, [&](const auto& objective, const auto& unifL, const auto& normL){
+            return nest;
+        }, budget);
+    }
+    /**Warm start from seed parameters: the n nests are the seeds plus normal
+    draws around them scaled by spread*(upper-lower)*/
+    template< typename Array, typename ObjFn, typename Seeds>
+    auto makeOptimizerFromSeeds(
+        const ObjFn& objFn, const Array& ul, const Seeds& seeds, double spread, int n, int totalMC, double tol, int seed, 
+        const swarm_utils::EvaluationBudget& budget=swarm_utils::EvaluationBudget()
+    ){
+        return Optimizer<ObjFn, Array>(objFn, ul, totalMC, tol, seed, [&](const auto& objective, const auto& unifL, const auto& normL){
+            return swarm_utils::getSeededPopulation(ul, seeds, spread, objective, normL, n);
+        }, budget);
+    }
+    /**Opposition based initialization: n nests drawn as by makeOptimizer plus
+    their opposites lower+upper-x, of which the best n are kept.  Costs n
+    extra evaluations.*/
+    template< typename Array, typename ObjFn>
+    auto makeOptimizerWithOpposition(
+        const ObjFn& objFn, const Array& ul, int n, int totalMC, double tol, int seed, 
+        const swarm_utils::EvaluationBudget& budget=swarm_utils::EvaluationBudget()
+    ){
+        return Optimizer<ObjFn, Array>(objFn, ul, totalMC, tol, seed, [&](const auto& objective, const auto& unifL, const auto& normL){
+            swarm_utils::Population nest=getNewNest(ul, objective, normL, n);
+            swarm_utils::addOpposites(&nest, ul, objective);
+            return nest;
+        }, budget);
+    }
+    /**Starts from n nests spread over the box by sampler, one of the policies
+    of sampling.h (for example swarm_utils::SobolSampling), instead of normal
+    draws around the centre*/
+    template< typename Array, typename ObjFn, typename Sampler>
+    auto makeOptimizerFromSampling(
+        const ObjFn& objFn, const Array& ul, const Sampler& sampler, int n, int totalMC, double tol, int seed, 
+        const swarm_utils::EvaluationBudget& budget=swarm_utils::EvaluationBudget()
+    ){
+        return Optimizer<ObjFn, Array>(objFn, ul, totalMC, tol, seed, [&](const auto& objective, const auto& unifL, const auto& normL){
+            return swarm_utils::getSampledPopulation(ul, sampler, objective, unifL, n);
+        }, budget);
+    }
+    template< typename Array, typename ObjFn>
+    auto makeOptimizerFromCheckpoint(const ObjFn& objFn, const Array& ul, const swarm_utils::Checkpoint& checkpoint, double tol){
+        return Optimizer<ObjFn, Array>(objFn, ul, checkpoint, tol);
+    }
+
+    template< typename Array, typename ObjFn>
+    auto optimize(const ObjFn& objFn, const Array& ul, int n, int totalMC, double tol, int seed){
+        auto optimizer=makeOptimizer(objFn, ul, n, totalMC, tol, seed);
+        while(optimizer.step()){}
+        return optimizer.result();
+    }
+
+    /**Same as optimize, but also stops once the budget of evaluations or wall
+    clock time is used up and returns the best point found so far*/
+    template< typename Array, typename ObjFn>
+    auto optimize(const ObjFn& objFn, const Array& ul, int n, int totalMC, double tol, int seed, const swarm_utils::EvaluationBudget& budget){
+        auto optimizer=makeOptimizer(objFn, ul, n, totalMC, tol, seed, budget);
+        while(optimizer.step()){}
+        return optimizer.result();
+    }
+
+    /**Same as optimize, but also stops early once any of the convergence
+    criteria is met*/
+    template< typename Array, typename ObjFn>
+    auto optimize(
+        const ObjFn& objFn, const Array& ul, int n, int totalMC, double tol, int seed, 
+        const swarm_utils::EvaluationBudget& budget, const swarm_utils::ConvergenceCriteria& criteria
+    ){
+        auto optimizer=makeOptimizer(objFn, ul, n, totalMC, tol, seed, budget);
+        optimizer.setConvergence(criteria);
+        while(optimizer.step()){}
+        return optimizer.result();
+    }
+
+    /**Same as optimize, calling the hooks of observer (see
+    swarm_utils::NullObserver) during the run*/
+    template< typename Array, typename ObjFn, typename Observer>
+    auto optimize(const ObjFn& objFn, const Array& ul, int n, int totalMC, double tol, int seed, Observer* observer){
+        Optimizer<ObjFn, Array, Observer&> optimizer(objFn, ul, totalMC, tol, seed, [&](const auto& objective, const auto& unifL, const auto& normL){
+            return getNewNest(ul, objective, normL, n);
+        }, swarm_utils::EvaluationBudget(), *observer);
+        while(optimizer.step()){}
+        return optimizer.result();
+    }
+
+    /**Same as optimize with a budget, publishing progress after every
+    iteration.  To stop the run from another thread, give the budget a
+    cancellation token.*/
+    template< typename Array, typename ObjFn>
+    auto optimize(
+        const ObjFn& objFn, const Array& ul, int n, int totalMC, double tol, int seed, 
+        const swarm_utils::EvaluationBudget& budget, swarm_utils::Progress* progress
+    ){
+        auto optimizer=makeOptimizer(objFn, ul, n, totalMC, tol, seed, budget);
+        optimizer.setProgress(progress);
+        while(optimizer.step()){}
+        return optimizer.result();
+    }
+
+    /**Restarts the search with a growing number of nests each time it
+    stagnates, until totalEvaluations are used or the best value drops below
+    tol.  See swarm_utils::RestartStrategy.*/
+    template< typename Array, typename ObjFn>
+    auto optimizeWithRestarts(
+        const ObjFn& objFn, const Array& ul, int n, long long totalEvaluations, double tol, int seed, 
+        const swarm_utils::RestartStrategy& strategy=swarm_utils::RestartStrategy()
+    ){
+        return swarm_utils::runRestarts([&](int numNests, int runSeed, const swarm_utils::EvaluationBudget& budget){
+            //the getPA schedule is spread over as many iterations as the whole budget allows
+            const int totalMC=std::max(1ll, totalEvaluations/numNests);
+            return makeOptimizer(objFn, ul, numNests, totalMC, tol, runSeed, budget);
+        }, n, totalEvaluations, tol, seed, strategy);
+    }
+
+    /**Same as optimize, but every checkpointEvery iterations the state is written
+    to checkpointPath on a background thread.  The run can be continued with resume.*/
+    template< typename Array, typename ObjFn>
+    auto optimize(const ObjFn& objFn, const Array& ul, int n, int totalMC, double tol, int seed, const std::string& checkpointPath, int checkpointEvery){
+        auto optimizer=makeOptimizer(objFn, ul, n, totalMC, tol, seed);
+        swarm_utils::runWithCheckpoints(&optimizer, checkpointPath, checkpointEvery);
+        return optimizer.result();
+    }
+
+    /**Continues a run from a checkpoint written by optimize; the result is
+    identical to the uninterrupted run.  Keeps writing checkpoints to the same
+    path.*/
+    template< typename Array, typename ObjFn>
+    auto resume(const ObjFn& objFn, const Array& ul, double tol, const std::string& checkpointPath, int checkpointEvery){
+        swarm_utils::Checkpoint checkpoint;
+        if(!swarm_utils::readCheckpoint(checkpointPath, &checkpoint)){
+            throw std::runtime_error("unable to read checkpoint "+checkpointPath);
         }
-        return nest[0];
+        auto optimizer=makeOptimizerFromCheckpoint(objFn, ul, checkpoint, tol);
+        swarm_utils::runWithCheckpoints(&optimizer, checkpointPath, checkpointEvery);
+        return optimizer.result();
+    }
+
+    /**Returns the final population ranked from best to worst*/
+    template< typename Array, typename ObjFn>
+    auto optimizePopulation(const ObjFn& objFn, const Array& ul, const swarm_utils::Population& nest, int totalMC, double tol, int seed){
+        auto optimizer=makeOptimizerFromPopulation(objFn, ul, nest, totalMC, tol, seed);
+        while(optimizer.step()){}
+        return optimizer.population();
+    }
+
+    /**Returns the final population ranked from best to worst*/
+    template< typename Array, typename ObjFn, typename Seeds>
+    auto optimizeFromSeeds(const ObjFn& objFn, const Array& ul, const Seeds& seeds, double spread, int n, int totalMC, double tol, int seed){
+        auto optimizer=makeOptimizerFromSeeds(objFn, ul, seeds, spread, n, totalMC, tol, seed);
+        while(optimizer.step()){}
+        return optimizer.population();
     }
 }
 
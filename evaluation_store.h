@@ -0,0 +1,273 @@
+#ifndef __SWARM_EVALUATION_STORE_H__
+#define __SWARM_EVALUATION_STORE_H__
+#include <vector>
+#include <string>
+#include <cstring>
+#include <cstdint>
+#include <stdexcept>
+#include <unordered_map>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "cache.h"
+
+namespace swarm_utils{
+    /**Append only log of objective evaluations shared between runs and processes.
+
+    File layout (native endianness):
+        header: 8 byte magic "SWRMEVL1", uint32 version, uint32 numParams
+        record: uint64 problemKey, double params[numParams], double value, uint64 checksum
+
+    The checksum is FNV-1a over the rest of the record.  Each record is written
+    with a single append, so a crash can at worst leave a torn final record;
+    on open the log is memory mapped and scanned, a torn final record is
+    truncated and corrupt records before it are skipped (see corrupt()).  Records for problemKey are loaded
+    into an index keyed by the parameters quantized to tolerance.
+
+    Appends hold a shared flock and opening holds an exclusive one, so a
+    record another process is appending is never taken for a torn tail and
+    truncated.*/
+    class EvaluationStore{
+    private:
+        struct Header{
+            char magic[8];
+            uint32_t version;
+            uint32_t numParams;
+        };
+        static const char* getMagic(){
+            return "SWRMEVL1";
+        }
+        static constexpr uint32_t version=1;
+        typedef std::unordered_map<std::vector<long long>, double, QuantizedKeyHash> Index;
+        Index index;
+        std::vector<long long> scratch;
+        std::vector<unsigned char> record;
+        uint64_t problemKey;
+        int numParams;
+        int fd=-1;
+        int syncEvery;
+        int unsynced=0;
+        double tolerance;
+        long long numHits=0;
+        long long numMisses=0;
+        long long numLoaded=0;
+        long long numCorrupt=0;
+
+        static uint64_t getChecksum(const unsigned char* data, std::size_t length){
+            uint64_t hash=14695981039346656037ull;
+            for(std::size_t i=0; i<length; ++i){
+                hash^=data[i];
+                hash*=1099511628211ull;
+            }
+            return hash;
+        }
+        std::size_t getRecordSize() const {
+            return sizeof(uint64_t)*(numParams+3);
+        }
+        void addToIndex(uint64_t key, const double* params, double value){
+            if(key!=problemKey){
+                return;
+            }
+            scratch.resize(numParams);
+            for(int i=0; i<numParams; ++i){
+                scratch[i]=quantizeValue(params[i], tolerance);
+            }
+            index[scratch]=value;
+            ++numLoaded;
+        }
+        /**Holds flock(fd, operation) for its lifetime*/
+        class FileLock{
+        private:
+            int fd;
+        public:
+            FileLock(int fd_, int operation):fd(fd_){
+                while(flock(fd, operation)!=0){
+                    if(errno!=EINTR){
+                        throw std::runtime_error("EvaluationStore: unable to lock log");
+                    }
+                }
+            }
+            FileLock(const FileLock&)=delete;
+            FileLock& operator=(const FileLock&)=delete;
+            ~FileLock(){
+                flock(fd, LOCK_UN);
+            }
+        };
+        void writeHeader(){
+            Header header;
+            std::memcpy(header.magic, getMagic(), sizeof(header.magic));
+            header.version=version;
+            header.numParams=numParams;
+            if(::write(fd, &header, sizeof(header))!=sizeof(header)){
+                throw std::runtime_error("EvaluationStore: unable to write header");
+            }
+        }
+        /**Maps the existing log, loads the valid records and drops a torn tail*/
+        void load(std::size_t fileSize){
+            void* mapped=mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+            if(mapped==MAP_FAILED){
+                throw std::runtime_error("EvaluationStore: unable to map log");
+            }
+            const unsigned char* data=(const unsigned char*)mapped;
+            Header header;
+            std::memcpy(&header, data, sizeof(header));
+            if(std::memcmp(header.magic, getMagic(), sizeof(header.magic))!=0||header.version!=version||(int)header.numParams!=numParams){
+                munmap(mapped, fileSize);
+                throw std::runtime_error("EvaluationStore: log has an incompatible header");
+            }
+            const std::size_t recordSize=getRecordSize();
+            std::size_t offset=sizeof(Header);
+            std::vector<double> params(numParams);
+            while(offset+recordSize<=fileSize){
+                const unsigned char* current=data+offset;
+                uint64_t checksum;
+                std::memcpy(&checksum, current+recordSize-sizeof(uint64_t), sizeof(uint64_t));
+                if(checksum!=getChecksum(current, recordSize-sizeof(uint64_t))){
+                    //the last record may be torn by a crash; earlier ones
+                    //are skipped so the records after them are kept
+                    if(offset+2*recordSize>fileSize){
+                        break;
+                    }
+                    ++numCorrupt;
+                    offset+=recordSize;
+                    continue;
+                }
+                uint64_t key;
+                double value;
+                std::memcpy(&key, current, sizeof(uint64_t));
+                std::memcpy(params.data(), current+sizeof(uint64_t), sizeof(double)*numParams);
+                std::memcpy(&value, current+sizeof(uint64_t)*(numParams+1), sizeof(double));
+                addToIndex(key, params.data(), value);
+                offset+=recordSize;
+            }
+            munmap(mapped, fileSize);
+            if(offset<fileSize&&ftruncate(fd, offset)!=0){
+                throw std::runtime_error("EvaluationStore: unable to truncate torn record");
+            }
+        }
+    public:
+        /**Opens (or creates) the log at path.  syncEvery>0 calls fdatasync after
+        that many appends; 0 leaves flushing to the operating system.*/
+        EvaluationStore(const std::string& path, int numParams_, uint64_t problemKey_, double tolerance_, int syncEvery_=0):
+            problemKey(problemKey_),
+            numParams(numParams_),
+            syncEvery(syncEvery_),
+            tolerance(tolerance_)
+        {
+            fd=::open(path.c_str(), O_RDWR|O_CREAT|O_APPEND, 0644);
+            if(fd<0){
+                throw std::runtime_error("EvaluationStore: unable to open "+path);
+            }
+            try{
+                FileLock lock(fd, LOCK_EX);
+                struct stat st;
+                if(fstat(fd, &st)!=0){
+                    throw std::runtime_error("EvaluationStore: unable to stat "+path);
+                }
+                if(st.st_size<(off_t)sizeof(Header)){
+                    if(st.st_size>0&&ftruncate(fd, 0)!=0){
+                        throw std::runtime_error("EvaluationStore: unable to reset "+path);
+                    }
+                    writeHeader();
+                }
+                else{
+                    load(st.st_size);
+                }
+            }
+            catch(...){
+                ::close(fd);
+                throw;
+            }
+            record.resize(getRecordSize());
+        }
+        EvaluationStore(const EvaluationStore&)=delete;
+        EvaluationStore& operator=(const EvaluationStore&)=delete;
+        ~EvaluationStore(){
+            if(fd>=0){
+                if(unsynced>0){
+                    fdatasync(fd);
+                }
+                ::close(fd);
+            }
+        }
+        template<typename Params>
+        bool find(const Params& params, double* value){
+            quantize(params, tolerance, &scratch);
+            auto it=index.find(scratch);
+            if(it==index.end()){
+                return false;
+            }
+            *value=it->second;
+            return true;
+        }
+        /**Appends the evaluation to the log and the index*/
+        template<typename Params>
+        void append(const Params& params, double value){
+            unsigned char* current=record.data();
+            std::memcpy(current, &problemKey, sizeof(uint64_t));
+            for(int i=0; i<numParams; ++i){
+                const double v=params[i];
+                std::memcpy(current+sizeof(uint64_t)*(i+1), &v, sizeof(double));
+            }
+            std::memcpy(current+sizeof(uint64_t)*(numParams+1), &value, sizeof(double));
+            const uint64_t checksum=getChecksum(current, record.size()-sizeof(uint64_t));
+            std::memcpy(current+record.size()-sizeof(uint64_t), &checksum, sizeof(uint64_t));
+            {
+                FileLock lock(fd, LOCK_SH);
+                if(::write(fd, current, record.size())!=(ssize_t)record.size()){
+                    throw std::runtime_error("EvaluationStore: unable to append record");
+                }
+            }
+            if(syncEvery>0&&++unsynced>=syncEvery){
+                fdatasync(fd);
+                unsynced=0;
+            }
+            quantize(params, tolerance, &scratch);
+            index[scratch]=value;
+        }
+        /**Returns the stored value or calls objFn and appends the result*/
+        template<typename Params, typename ObjFn>
+        double evaluate(const Params& params, const ObjFn& objFn){
+            double value;
+            if(find(params, &value)){
+                ++numHits;
+                return value;
+            }
+            ++numMisses;
+            value=objFn(params);
+            append(params, value);
+            return value;
+        }
+        /**Number of records for this problem read from the log at startup*/
+        long long loaded() const {
+            return numLoaded;
+        }
+        /**Records with a bad checksum before the end of the log, which were
+        skipped at startup.  A bad final record is taken to be torn by a
+        crash and truncated instead.*/
+        long long corrupt() const {
+            return numCorrupt;
+        }
+        long long hits() const {
+            return numHits;
+        }
+        long long misses() const {
+            return numMisses;
+        }
+    };
+
+    /**Wraps an objective so that evaluations are read from and written to the
+    store.  Can be combined with cacheObjective; the store must outlive the
+    optimization.*/
+    template<typename ObjFn>
+    auto storeObjective(const ObjFn& objFn, EvaluationStore* store){
+        return [=](const auto& params){
+            return store->evaluate(params, objFn);
+        };
+    }
+}
+
+#endif
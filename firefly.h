@@ -1,10 +1,22 @@
 #ifndef __FIREFLY_H__
 #define __FIREFLY_H__
 #include "FunctionalUtilities.h"
+#include <string>
+#include <stdexcept>
 #include "utils.h"
-#include "SimulateNorm.h"
+#include "kdtree.h"
+#include "checkpoint.h"
+#include "budget.h"
+#include "convergence.h"
+#include "restart.h"
+#include "observer.h"
+#include "statistics.h"
+#include "boundary.h"
+#include "sampling.h"
+#include "opposition.h"
 namespace firefly{
     constexpr double beta=1;
+    constexpr double delta=.97; //annealing of the random step
     constexpr int n=25;
     template<typename FireFlies>
     void sortNest(FireFlies& fireflyRef){
@@ -23,28 +35,86 @@ namespace firefly{
         return xi+step*(xj-xi);
     }
     
-    template<typename FireFlies, typename Norm, typename ObjFn, typename Array>
-    void getUpdate(FireFlies* fireflies, const ObjFn& objFun, const Array& ul, double beta, double gamma, double vol, const Norm& norm){
+    /**onMove(i, previousValue, newValue) is called after firefly i moves.
+    boundary maps moves that leave the box back into it, see boundary.h.
+    No firefly moves once stop() is true.*/
+    template<
+        typename FireFlies, typename Norm, typename ObjFn, typename Array, typename OnMove, 
+        typename Boundary=swarm_utils::ClampBoundary, typename Stop=swarm_utils::NeverStop
+    >
+    void getUpdate(
+        FireFlies* fireflies, const ObjFn& objFun, const Array& ul, double beta, double gamma, double vol, const Norm& norm, const OnMove& onMove,
+        const Boundary& boundary=Boundary(), const Stop& stop=Stop()
+    ){
         FireFlies& firefliesRef= *fireflies;
         const int numFlies=firefliesRef.size(); //num flies
         const int numParams=firefliesRef[0].first.size(); //num parameters
         //fireflies are sorted
         for(int i=0; i<numFlies; ++i){
             for(int j=0; j<numFlies; ++j){
+                if(stop()){
+                    return;
+                }
                 //minimizing, hence the opposite sign
                 if(firefliesRef[j].second<firefliesRef[i].second){
                     const double r=getDistanceSq(firefliesRef[i].first, firefliesRef[j].first);
                     for(int k=0; k<numParams; ++k){
-                        firefliesRef[i].first[k]=swarm_utils::getTruncatedParameter(
-                            ul[k].lower, ul[k].upper,
-                            getNextDetStep(
-                                firefliesRef[i].first[k],
-                                firefliesRef[j].first[k],beta*exp(-gamma*r)
-                            )+vol*norm()*(ul[k].upper-ul[k].lower) //should this be scaled by size of input range?
-                        );
+                        const double moved=getNextDetStep(
+                            firefliesRef[i].first[k],
+                            firefliesRef[j].first[k],beta*exp(-gamma*r)
+                        )+vol*norm()*(ul[k].upper-ul[k].lower); //should this be scaled by size of input range?
+                        firefliesRef[i].first[k]=boundary(moved, ul[k].lower, ul[k].upper, firefliesRef[i].first[k], norm);
                     }
+                    const double previousValue=firefliesRef[i].second;
                     firefliesRef[i].second=objFun(firefliesRef[i].first);
+                    onMove(i, previousValue, firefliesRef[i].second);
+                }
+            }
+        }
+    }
+    template<typename FireFlies, typename Norm, typename ObjFn, typename Array>
+    void getUpdate(FireFlies* fireflies, const ObjFn& objFun, const Array& ul, double beta, double gamma, double vol, const Norm& norm){
+        getUpdate(fireflies, objFun, ul, beta, gamma, vol, norm, [](const auto& i, const auto& previousValue, const auto& newValue){});
+    }
+
+    /**Same update as getUpdate, but each firefly is only attracted to its k nearest
+    brighter fireflies (numNeighbours).  Neighbourhoods are found from the positions at the start of the
+    generation using the k-d tree, which is rebuilt here.  Moves are applied brightest first,
+    as in getUpdate.*/
+    template<
+        typename FireFlies, typename Norm, typename ObjFn, typename Array, typename OnMove, 
+        typename Boundary=swarm_utils::ClampBoundary, typename Stop=swarm_utils::NeverStop
+    >
+    void getUpdateNearest(
+        FireFlies* fireflies, const ObjFn& objFun, const Array& ul, 
+        double beta, double gamma, double vol, const Norm& norm, 
+        int numNeighbours, swarm_utils::KdTree* tree, std::vector<int>* neighbours,
+        const OnMove& onMove, const Boundary& boundary=Boundary(), const Stop& stop=Stop()
+    ){
+        FireFlies& firefliesRef= *fireflies;
+        const int numFlies=firefliesRef.size(); //num flies
+        const int numParams=firefliesRef[0].first.size(); //num parameters
+        tree->rebuild(firefliesRef);
+        for(int i=0; i<numFlies; ++i){
+            tree->nearest(firefliesRef[i].first, numNeighbours, [&](int j){
+                return firefliesRef[j].second<firefliesRef[i].second;
+            }, neighbours);
+            std::sort(neighbours->begin(), neighbours->end());//fireflies are sorted, so this is brightest first
+            for(const int j:*neighbours){
+                if(stop()){
+                    return;
                 }
+                const double r=getDistanceSq(firefliesRef[i].first, firefliesRef[j].first);
+                for(int k=0; k<numParams; ++k){
+                    const double moved=getNextDetStep(
+                        firefliesRef[i].first[k],
+                        firefliesRef[j].first[k],beta*exp(-gamma*r)
+                    )+vol*norm()*(ul[k].upper-ul[k].lower);
+                    firefliesRef[i].first[k]=boundary(moved, ul[k].lower, ul[k].upper, firefliesRef[i].first[k], norm);
+                }
+                const double previousValue=firefliesRef[i].second;
+                firefliesRef[i].second=objFun(firefliesRef[i].first);
+                onMove(i, previousValue, firefliesRef[i].second);
             }
         }
     }
@@ -58,6 +128,277 @@ namespace firefly{
     }
 
 
+    /**All pairs attraction, see getUpdate*/
+    struct AllPairsUpdate{
+        template<
+            typename FireFlies, typename Norm, typename ObjFn, typename Array, typename OnMove, 
+            typename Boundary=swarm_utils::ClampBoundary, typename Stop=swarm_utils::NeverStop
+        >
+        void operator()(
+            FireFlies* fireflies, const ObjFn& objFun, const Array& ul, double beta, double gamma, double vol, const Norm& norm, const OnMove& onMove,
+            const Boundary& boundary=Boundary(), const Stop& stop=Stop()
+        ){
+            getUpdate(fireflies, objFun, ul, beta, gamma, vol, norm, onMove, boundary, stop);
+        }
+    };
+    /**k nearest brighter neighbour attraction, see getUpdateNearest*/
+    struct NearestUpdate{
+        int k;
+        swarm_utils::KdTree tree;
+        std::vector<int> neighbours;
+        NearestUpdate(int k_):k(k_){
+            neighbours.reserve(k);
+        }
+        template<
+            typename FireFlies, typename Norm, typename ObjFn, typename Array, typename OnMove, 
+            typename Boundary=swarm_utils::ClampBoundary, typename Stop=swarm_utils::NeverStop
+        >
+        void operator()(
+            FireFlies* fireflies, const ObjFn& objFun, const Array& ul, double beta, double gamma, double vol, const Norm& norm, const OnMove& onMove,
+            const Boundary& boundary=Boundary(), const Stop& stop=Stop()
+        ){
+            getUpdateNearest(fireflies, objFun, ul, beta, gamma, vol, norm, k, &tree, &neighbours, onMove, boundary, stop);
+        }
+    };
+
+    /**Firefly algorithm as an object that advances one generation per call to
+    step, so that many optimizations can be interleaved on a single thread.
+    Update is AllPairsUpdate or NearestUpdate.  Observer receives the hooks of
+    swarm_utils::NullObserver; it is held by value, or by reference if Observer
+    is a reference type.*/
+    template<typename ObjFn, typename Array, typename Update=AllPairsUpdate, typename Observer=swarm_utils::NullObserver>
+    class Optimizer{
+    private:
+        ObjFn objFn;
+        Array ul;
+        Update update;
+        swarm_utils::Population fireflies;
+        swarm_utils::RandomGenerator rng;
+        swarm_utils::EvaluationBudget budget;
+        swarm_utils::ConvergenceMonitor monitor;
+        swarm_utils::Progress* progress=nullptr;
+        Observer observer;
+        swarm_utils::RunStatistics stats;
+        int i;
+        int totalMC;
+        double deltaT;
+        double alpha0=.25;//L*.1;
+        swarm_utils::Boundary boundary=swarm_utils::Boundary::clamp;
+        double jumpingRate=0.0;
+        swarm_utils::Population opposites;
+        double gamma;
+        void setScale(){
+            const double L=futilities::sum(ul, [](const auto& v, const auto& index){
+                return v.upper-v.lower;
+            }); //average scale
+            gamma=1.0/sqrt(L);
+        }
+        /**All evaluations go through the budget*/
+        auto getObjective(){
+            return [this](const auto& params){
+                const uint64_t start=swarm_utils::readTicks();
+                const double value=budget.evaluate(params, objFn);
+                stats.evaluationTicks+=swarm_utils::readTicks()-start;
+                observer.onEvaluation(params, value);
+                return value;
+            };
+        }
+    public:
+        /**The starting population is initialize(objective, unif, norm) using the
+        optimizer's generator and budget*/
+        template<typename Initialize>
+        Optimizer(
+            const ObjFn& objFn_, const Array& ul_, int totalMC_, int seed, const Initialize& initialize, 
+            const Update& update_=Update(), const swarm_utils::EvaluationBudget& budget_=swarm_utils::EvaluationBudget(),
+            Observer observer_=Observer()
+        ):
+            objFn(objFn_), ul(ul_), update(update_), rng(seed), budget(budget_), observer(observer_), i(0), totalMC(totalMC_), deltaT(delta)
+        {
+            setScale();
+            auto unifL=[&](){return 2*rng.getUniform()-1;}; //to keep uniform
+            auto normL=[&](){return rng.getNorm();};
+            fireflies=initialize(getObjective(), unifL, normL);
+            sortNest(fireflies);
+        }
+        /**Continues from a checkpoint*/
+        Optimizer(
+            const ObjFn& objFn_, const Array& ul_, const swarm_utils::Checkpoint& checkpoint, 
+            const Update& update_=Update(), const swarm_utils::EvaluationBudget& budget_=swarm_utils::EvaluationBudget(),
+            Observer observer_=Observer()
+        ):
+            objFn(objFn_), ul(ul_), update(update_), fireflies(checkpoint.population), rng(0), budget(budget_), observer(observer_),
+            i(checkpoint.iteration), totalMC(checkpoint.totalMC), deltaT(checkpoint.schedule)
+        {
+            setScale();
+            swarm_utils::checkCheckpoint(checkpoint, ul.size());
+            if(!rng.setState(checkpoint.rngState)){
+                throw std::invalid_argument("checkpoint: corrupt random generator state");
+            }
+        }
+        bool done() const {
+            return i>=totalMC||budget.exhausted()||monitor.converged();
+        }
+        /**Adds early stopping rules; call before the first step*/
+        void setConvergence(const swarm_utils::ConvergenceCriteria& criteria){
+            monitor=swarm_utils::ConvergenceMonitor(criteria);
+        }
+        /**After each generation, with probability rate, evaluates the
+        opposites of the fireflies within the box they span and keeps the
+        best (generation jumping, see opposition.h).  0, the default, never
+        jumps.*/
+        void setOppositionJumping(double rate){
+            jumpingRate=rate;
+        }
+        /**How fireflies that leave the box are brought back; clamp by default*/
+        void setBoundary(swarm_utils::Boundary boundary_){
+            boundary=boundary_;
+        }
+        /**Publishes the iteration, evaluations and best point after every
+        generation for other threads to read*/
+        void setProgress(swarm_utils::Progress* progress_){
+            progress=progress_;
+        }
+        /**Which early stopping rule ended the run, if any*/
+        swarm_utils::Convergence convergence() const {
+            return monitor.getReason();
+        }
+        /**Runs one generation; does nothing once done.  Returns false when done.*/
+        bool step(){
+            if(done()){
+                return false;
+            }
+            auto normL=[&](){return rng.getNorm();};
+            observer.onGenerationStart(i, fireflies);
+            const uint64_t evaluationTicks=stats.evaluationTicks;
+            const uint64_t start=swarm_utils::readTicks();
+            auto onMove=[&](int index, double previousValue, double newValue){
+                stats.improvingReplacements+=newValue<previousValue;
+                observer.onReplacement(index, previousValue, newValue);
+            };
+            swarm_utils::withBoundary(boundary, [&](const auto& policy){
+                update(&fireflies, getObjective(), ul, beta, gamma, alpha0*deltaT, normL, onMove, policy, [&](){return budget.exhausted();});
+            });
+            const uint64_t end=swarm_utils::readTicks();
+            stats.generationTicks+=end-start-(stats.evaluationTicks-evaluationTicks);
+            sortNest(fireflies);
+            const uint64_t sorted=swarm_utils::readTicks();
+            stats.sortTicks+=sorted-end;
+            if(jumpingRate>0&&rng.getUniform()<=jumpingRate){
+                const uint64_t jumpEvaluationTicks=stats.evaluationTicks;
+                swarm_utils::jumpToOpposites(&fireflies, &opposites, getObjective());
+                stats.generationTicks+=swarm_utils::readTicks()-sorted-(stats.evaluationTicks-jumpEvaluationTicks);
+            }
+            observer.onGenerationEnd(i, fireflies);
+            deltaT*=delta;
+            monitor.update(fireflies, ul);
+            ++i;
+            if(progress){
+                progress->publish(i, budget.evaluations(), best());
+            }
+            return !done();
+        }
+        /**Best point found so far; fireflies move in place, so this can differ
+        from population()[0] if the budget ran out mid generation*/
+        const std::pair<std::vector<double>, double>& best() const {
+            return budget.best().second<fireflies[0].second?budget.best():fireflies[0];
+        }
+        /**Counters and phase timers since construction (or since resuming
+        from a checkpoint); fireflies are never abandoned*/
+        swarm_utils::RunStatistics statistics() const {
+            swarm_utils::RunStatistics current=stats;
+            current.iterations=i;
+            current.evaluations=budget.evaluations();
+            return current;
+        }
+        swarm_utils::OptimizeResult result() const {
+            return swarm_utils::OptimizeResult(best(), statistics());
+        }
+        /**Ranked from best to worst*/
+        const swarm_utils::Population& population() const {
+            return fireflies;
+        }
+        int iteration() const {
+            return i;
+        }
+        long long evaluations() const {
+            return budget.evaluations();
+        }
+        int totalIterations() const {
+            return totalMC;
+        }
+        /**Annealing factor deltaT of the random step*/
+        double schedule() const {
+            return deltaT;
+        }
+        const swarm_utils::RandomGenerator& generator() const {
+            return rng;
+        }
+    };
+
+    template< typename Array, typename ObjFn, typename Update=AllPairsUpdate>
+    auto makeOptimizer(
+        const ObjFn& objFn, const Array& ul, int totalMC, int seed, 
+        const Update& update=Update(), const swarm_utils::EvaluationBudget& budget=swarm_utils::EvaluationBudget()
+    ){
+        return Optimizer<ObjFn, Array, Update>(objFn, ul, totalMC, seed, [&](const auto& objective, const auto& unifL, const auto& normL){
+            return getInitialFirefly(ul, objective, unifL, n);
+        }, update, budget);
+    }
+    /**Warm start from an existing population, for example the result of a
+    previous run.  The objective values are trusted; if the objective has
+    changed, use makeOptimizerFromSeeds instead.*/
+    template< typename Array, typename ObjFn, typename Update=AllPairsUpdate>
+    auto makeOptimizerFromPopulation(
+        const ObjFn& objFn, const Array& ul, const swarm_utils::Population& fireflies, int totalMC, int seed, 
+        const Update& update=Update(), const swarm_utils::EvaluationBudget& budget=swarm_utils::EvaluationBudget()
+    ){
+        return Optimizer<ObjFn, Array, Update>(objFn, ul, totalMC, seed, [&](const auto& objective, const auto& unifL, const auto& normL){
+            return fireflies;
+        }, update, budget);
+    }
+    /**Warm start from seed parameters: the numFlies fireflies are the seeds plus
+    normal draws around them scaled by spread*(upper-lower)*/
+    template< typename Array, typename ObjFn, typename Seeds, typename Update=AllPairsUpdate>
+    auto makeOptimizerFromSeeds(
+        const ObjFn& objFn, const Array& ul, const Seeds& seeds, double spread, int numFlies, int totalMC, int seed, 
+        const Update& update=Update(), const swarm_utils::EvaluationBudget& budget=swarm_utils::EvaluationBudget()
+    ){
+        return Optimizer<ObjFn, Array, Update>(objFn, ul, totalMC, seed, [&](const auto& objective, const auto& unifL, const auto& normL){
+            return swarm_utils::getSeededPopulation(ul, seeds, spread, objective, normL, numFlies);
+        }, update, budget);
+    }
+    /**Opposition based initialization: n fireflies drawn as by makeOptimizer
+    plus their opposites lower+upper-x, of which the best n are kept.  Costs n
+    extra evaluations.*/
+    template< typename Array, typename ObjFn, typename Update=AllPairsUpdate>
+    auto makeOptimizerWithOpposition(
+        const ObjFn& objFn, const Array& ul, int totalMC, int seed, 
+        const Update& update=Update(), const swarm_utils::EvaluationBudget& budget=swarm_utils::EvaluationBudget()
+    ){
+        return Optimizer<ObjFn, Array, Update>(objFn, ul, totalMC, seed, [&](const auto& objective, const auto& unifL, const auto& normL){
+            swarm_utils::Population fireflies=getInitialFirefly(ul, objective, unifL, n);
+            swarm_utils::addOpposites(&fireflies, ul, objective);
+            return fireflies;
+        }, update, budget);
+    }
+    /**Starts from numFlies fireflies spread over the box by sampler, one of
+    the policies of sampling.h (for example swarm_utils::SobolSampling)*/
+    template< typename Array, typename ObjFn, typename Sampler, typename Update=AllPairsUpdate>
+    auto makeOptimizerFromSampling(
+        const ObjFn& objFn, const Array& ul, const Sampler& sampler, int numFlies, int totalMC, int seed, 
+        const Update& update=Update(), const swarm_utils::EvaluationBudget& budget=swarm_utils::EvaluationBudget()
+    ){
+        return Optimizer<ObjFn, Array, Update>(objFn, ul, totalMC, seed, [&](const auto& objective, const auto& unifL, const auto& normL){
+            //unifL is on (-1, 1] here, the samplers draw from (0, 1]
+            auto unif=[&](){return .5*(unifL()+1);};
+            return swarm_utils::getSampledPopulation(ul, sampler, objective, unif, numFlies);
+        }, update, budget);
+    }
+    template< typename Array, typename ObjFn, typename Update=AllPairsUpdate>
+    auto makeOptimizerFromCheckpoint(const ObjFn& objFn, const Array& ul, const swarm_utils::Checkpoint& checkpoint, const Update& update=Update()){
+        return Optimizer<ObjFn, Array, Update>(objFn, ul, checkpoint, update);
+    }
+
     template< typename Array, typename ObjFn>
     auto optimize(
         const ObjFn& objFn, 
@@ -65,39 +406,178 @@ namespace firefly{
         int totalMC,  
         int seed
     ){
-        srand(seed);
-        const int numParams=ul.size();
-        const double L=futilities::sum(ul, [](const auto& v, const auto& index){
-            return v.upper-v.lower;
-        }); //average scale
-        const double alpha0=.25;//L*.1;
-        const double gamma=1.0/sqrt(L);   
-        const double delta=.97;
-        double deltaT=delta;
-        SimulateNorm norm(seed);
-       
-        auto unifL=[](){return 2*swarm_utils::getUniform()-1;}; //to keep uniform
-
-        auto fireflies=getInitialFirefly(ul, objFn, unifL, n);
-        auto normL=[&](){return norm.getNorm();};
-        sortNest(fireflies);
-        for(int i=0; i<totalMC; ++i){
-            
-            getUpdate(&fireflies, objFn, ul, beta, gamma, alpha0*deltaT, normL);
-            sortNest(fireflies);
-            deltaT*=delta;
-            #ifdef VERBOSE_FLAG
-                std::cout<<"Index: "<<i<<", Param Vals: ";
-                for(auto& v:fireflies[0].first){
-                    std::cout<<v<<", ";
-                }
-                std::cout<<", Obj Val: "<<fireflies[0].second<<std::endl;
-            #endif
+        auto optimizer=makeOptimizer(objFn, ul, totalMC, seed);
+        while(optimizer.step()){}
+        return optimizer.result();
+    }
+
+    /**Same as optimize, but also stops once the budget of evaluations or wall
+    clock time is used up and returns the best point found so far*/
+    template< typename Array, typename ObjFn>
+    auto optimize(
+        const ObjFn& objFn, 
+        const Array& ul, 
+        int totalMC,  
+        int seed,
+        const swarm_utils::EvaluationBudget& budget
+    ){
+        auto optimizer=makeOptimizer(objFn, ul, totalMC, seed, AllPairsUpdate(), budget);
+        while(optimizer.step()){}
+        return optimizer.result();
+    }
+
+    /**Same as optimize, but also stops early once any of the convergence
+    criteria is met*/
+    template< typename Array, typename ObjFn>
+    auto optimize(
+        const ObjFn& objFn, 
+        const Array& ul, 
+        int totalMC,  
+        int seed,
+        const swarm_utils::EvaluationBudget& budget,
+        const swarm_utils::ConvergenceCriteria& criteria
+    ){
+        auto optimizer=makeOptimizer(objFn, ul, totalMC, seed, AllPairsUpdate(), budget);
+        optimizer.setConvergence(criteria);
+        while(optimizer.step()){}
+        return optimizer.result();
+    }
+
+    /**Same as optimize, calling the hooks of observer (see
+    swarm_utils::NullObserver) during the run*/
+    template< typename Array, typename ObjFn, typename Observer>
+    auto optimize(
+        const ObjFn& objFn, 
+        const Array& ul, 
+        int totalMC,  
+        int seed,
+        Observer* observer
+    ){
+        Optimizer<ObjFn, Array, AllPairsUpdate, Observer&> optimizer(objFn, ul, totalMC, seed, [&](const auto& objective, const auto& unifL, const auto& normL){
+            return getInitialFirefly(ul, objective, unifL, n);
+        }, AllPairsUpdate(), swarm_utils::EvaluationBudget(), *observer);
+        while(optimizer.step()){}
+        return optimizer.result();
+    }
+
+    /**Same as optimize with a budget, publishing progress after every
+    generation.  To stop the run from another thread, give the budget a
+    cancellation token.*/
+    template< typename Array, typename ObjFn>
+    auto optimize(
+        const ObjFn& objFn, 
+        const Array& ul, 
+        int totalMC,  
+        int seed,
+        const swarm_utils::EvaluationBudget& budget,
+        swarm_utils::Progress* progress
+    ){
+        auto optimizer=makeOptimizer(objFn, ul, totalMC, seed, AllPairsUpdate(), budget);
+        optimizer.setProgress(progress);
+        while(optimizer.step()){}
+        return optimizer.result();
+    }
+
+    /**Restarts the algorithm with a growing number of fireflies each time it
+    stagnates, until totalEvaluations are used or the best value drops below
+    tol.  See swarm_utils::RestartStrategy.*/
+    template< typename Array, typename ObjFn>
+    auto optimizeWithRestarts(
+        const ObjFn& objFn, 
+        const Array& ul, 
+        int numFlies,
+        long long totalEvaluations,  
+        double tol,
+        int seed,
+        const swarm_utils::RestartStrategy& strategy=swarm_utils::RestartStrategy()
+    ){
+        return swarm_utils::runRestarts([&](int numMembers, int runSeed, const swarm_utils::EvaluationBudget& budget){
+            const int totalMC=std::max(1ll, totalEvaluations/numMembers);
+            return Optimizer<ObjFn, Array>(objFn, ul, totalMC, runSeed, [&](const auto& objective, const auto& unifL, const auto& normL){
+                return getInitialFirefly(ul, objective, unifL, numMembers);
+            }, AllPairsUpdate(), budget);
+        }, numFlies, totalEvaluations, tol, seed, strategy);
+    }
+
+    /**Same as optimize, but every checkpointEvery generations the state is
+    written to checkpointPath on a background thread.  The run can be
+    continued with resume.*/
+    template< typename Array, typename ObjFn>
+    auto optimize(
+        const ObjFn& objFn, 
+        const Array& ul, 
+        int totalMC,  
+        int seed,
+        const std::string& checkpointPath,
+        int checkpointEvery
+    ){
+        auto optimizer=makeOptimizer(objFn, ul, totalMC, seed);
+        swarm_utils::runWithCheckpoints(&optimizer, checkpointPath, checkpointEvery);
+        return optimizer.result();
+    }
+
+    /**Continues a run from a checkpoint written by optimize; the result is
+    identical to the uninterrupted run.  Keeps writing checkpoints to the
+    same path.*/
+    template< typename Array, typename ObjFn>
+    auto resume(
+        const ObjFn& objFn, 
+        const Array& ul, 
+        const std::string& checkpointPath,
+        int checkpointEvery
+    ){
+        swarm_utils::Checkpoint checkpoint;
+        if(!swarm_utils::readCheckpoint(checkpointPath, &checkpoint)){
+            throw std::runtime_error("unable to read checkpoint "+checkpointPath);
         }
-        return fireflies[0];
+        auto optimizer=makeOptimizerFromCheckpoint(objFn, ul, checkpoint);
+        swarm_utils::runWithCheckpoints(&optimizer, checkpointPath, checkpointEvery);
+        return optimizer.result();
+    }
 
+    /**k nearest brighter neighbour variant: each firefly is attracted to at most k
+    fireflies per generation instead of all brighter ones*/
+    template< typename Array, typename ObjFn>
+    auto optimizeNearest(
+        const ObjFn& objFn, 
+        const Array& ul, 
+        int totalMC,  
+        int k,
+        int seed
+    ){
+        auto optimizer=makeOptimizer(objFn, ul, totalMC, seed, NearestUpdate(k));
+        while(optimizer.step()){}
+        return optimizer.result();
+    }
 
+    /**Returns the final population ranked from best to worst*/
+    template< typename Array, typename ObjFn>
+    auto optimizePopulation(
+        const ObjFn& objFn, 
+        const Array& ul, 
+        const swarm_utils::Population& fireflies,
+        int totalMC,  
+        int seed
+    ){
+        auto optimizer=makeOptimizerFromPopulation(objFn, ul, fireflies, totalMC, seed);
+        while(optimizer.step()){}
+        return optimizer.population();
+    }
 
+    /**Returns the final population ranked from best to worst*/
+    template< typename Array, typename ObjFn, typename Seeds>
+    auto optimizeFromSeeds(
+        const ObjFn& objFn, 
+        const Array& ul, 
+        const Seeds& seeds,
+        double spread,
+        int numFlies,
+        int totalMC,  
+        int seed
+    ){
+        auto optimizer=makeOptimizerFromSeeds(objFn, ul, seeds, spread, numFlies, totalMC, seed);
+        while(optimizer.step()){}
+        return optimizer.population();
     }
 
 }
@@ -0,0 +1,128 @@
+#ifndef __SWARM_KDTREE_H__
+#define __SWARM_KDTREE_H__
+#include <vector>
+#include <algorithm>
+#include <utility>
+
+namespace swarm_utils{
+    /**Balanced k-d tree over a snapshot of population positions.
+    The tree is stored implicitly in a permutation of the population indices
+    (the median of each range is the node) so rebuilding every generation only
+    reuses the existing buffers and does not allocate once the population size
+    is stable.*/
+    class KdTree{
+    private:
+        std::vector<double> points; //row major, numPoints x numParams
+        std::vector<int> index;
+        std::vector<int> splitDim;
+        std::vector<std::pair<double, int> > heap;
+        int numPoints=0;
+        int numParams=0;
+
+        double getDistanceSq(const double* point, int i) const {
+            const double* other=&points[i*numParams];
+            double r=0.0;
+            for(int k=0; k<numParams; ++k){
+                const double diff=point[k]-other[k];
+                r+=diff*diff;
+            }
+            return r;
+        }
+        int getWidestDim(int lo, int hi) const {
+            int best=0;
+            double bestSpread=-1.0;
+            for(int k=0; k<numParams; ++k){
+                double mn=points[index[lo]*numParams+k];
+                double mx=mn;
+                for(int i=lo+1; i<hi; ++i){
+                    const double v=points[index[i]*numParams+k];
+                    mn=v<mn?v:mn;
+                    mx=v>mx?v:mx;
+                }
+                if(mx-mn>bestSpread){
+                    bestSpread=mx-mn;
+                    best=k;
+                }
+            }
+            return best;
+        }
+        void build(int lo, int hi){
+            if(hi-lo<=1){
+                return;
+            }
+            const int mid=(lo+hi)/2;
+            const int dim=getWidestDim(lo, hi);
+            splitDim[mid]=dim;
+            std::nth_element(index.begin()+lo, index.begin()+mid, index.begin()+hi, [&](int a, int b){
+                return points[a*numParams+dim]<points[b*numParams+dim];
+            });
+            build(lo, mid);
+            build(mid+1, hi);
+        }
+        void push(double r, int i, int k){
+            if((int)heap.size()<k){
+                heap.emplace_back(r, i);
+                std::push_heap(heap.begin(), heap.end());
+            }
+            else if(r<heap.front().first){
+                std::pop_heap(heap.begin(), heap.end());
+                heap.back()=std::make_pair(r, i);
+                std::push_heap(heap.begin(), heap.end());
+            }
+        }
+        template<typename Accept>
+        void search(const double* point, int lo, int hi, int k, const Accept& accept){
+            if(hi<=lo){
+                return;
+            }
+            const int mid=(lo+hi)/2;
+            const int i=index[mid];
+            if(accept(i)){
+                push(getDistanceSq(point, i), i, k);
+            }
+            if(hi-lo==1){
+                return;
+            }
+            const int dim=splitDim[mid];
+            const double diff=point[dim]-points[i*numParams+dim];
+            const bool left=diff<0;
+            search(point, left?lo:mid+1, left?mid:hi, k, accept);
+            //only visit the far side if the splitting plane is closer than the current k-th neighbour
+            if((int)heap.size()<k||diff*diff<heap.front().first){
+                search(point, left?mid+1:lo, left?hi:mid, k, accept);
+            }
+        }
+    public:
+        /**Copies the positions of the population and rebuilds the tree*/
+        template<typename Population>
+        void rebuild(const Population& population){
+            numPoints=population.size();
+            numParams=numPoints>0?population[0].first.size():0;
+            points.resize(numPoints*numParams);
+            index.resize(numPoints);
+            splitDim.resize(numPoints);
+            for(int i=0; i<numPoints; ++i){
+                std::copy(population[i].first.begin(), population[i].first.end(), points.begin()+i*numParams);
+                index[i]=i;
+            }
+            build(0, numPoints);
+        }
+        /**Finds the (at most) k nearest points for which accept(index) is true.
+        Results are written to neighbours as population indices, nearest first.*/
+        template<typename Params, typename Accept>
+        void nearest(const Params& point, int k, const Accept& accept, std::vector<int>* neighbours){
+            heap.clear();
+            neighbours->clear();
+            if(k<=0){
+                return;
+            }
+            search(&point[0], 0, numPoints, k, accept);
+            std::sort_heap(heap.begin(), heap.end());
+            for(const auto& v:heap){
+                neighbours->push_back(v.second);
+            }
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,139 @@
+#ifndef __SWARM_LOCALSEARCH_H__
+#define __SWARM_LOCALSEARCH_H__
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <cmath>
+#include "utils.h"
+
+namespace swarm_utils{
+    /**When an optimizer polishes its best point with nelderMead: every period
+    generations and/or once the best value has not improved for stagnation
+    generations (0 disables either trigger).  Each polish may use up to
+    maxEvaluations evaluations, starting from a simplex with edges of
+    initialStep times the width of the box.*/
+    struct LocalRefinement{
+        int period=0;
+        int stagnation=0;
+        int maxEvaluations=200;
+        double initialStep=.01;
+        LocalRefinement& withPeriod(int period_){
+            period=period_;
+            return *this;
+        }
+        LocalRefinement& withStagnation(int stagnation_){
+            stagnation=stagnation_;
+            return *this;
+        }
+        LocalRefinement& withMaxEvaluations(int maxEvaluations_){
+            maxEvaluations=maxEvaluations_;
+            return *this;
+        }
+        LocalRefinement& withInitialStep(double initialStep_){
+            initialStep=initialStep_;
+            return *this;
+        }
+        bool enabled() const {
+            return period>0||stagnation>0;
+        }
+    };
+
+    /**Nelder-Mead simplex search from start (whose value is startValue, so
+    it is not evaluated again) with the usual coefficients: reflection 1,
+    expansion 2, contraction and shrink 1/2.  Every vertex is clamped into
+    the box ul.  Stops after maxEvaluations evaluations, once the best value
+    is at most target, or once the simplex has collapsed.  Returns the best
+    vertex.*/
+    template<typename Array, typename ObjFn>
+    std::pair<std::vector<double>, double> nelderMead(
+        const std::vector<double>& start, double startValue, const Array& ul, const ObjFn& objFn,
+        int maxEvaluations, double initialStep, double target
+    ){
+        typedef std::pair<std::vector<double>, double> Vertex;
+        const int d=start.size();
+        int numEvaluations=0;
+        auto evaluate=[&](Vertex* vertex){
+            for(int j=0; j<d; ++j){
+                vertex->first[j]=getTruncatedParameter(ul[j].lower, ul[j].upper, vertex->first[j]);
+            }
+            vertex->second=objFn(vertex->first);
+            ++numEvaluations;
+        };
+        std::vector<Vertex> simplex(d+1, Vertex(start, startValue));
+        for(int j=0; j<d&&numEvaluations<maxEvaluations; ++j){
+            const double step=initialStep*(ul[j].upper-ul[j].lower);
+            //step away from the nearest face so the vertex stays distinct
+            simplex[j+1].first[j]+=start[j]+step<=ul[j].upper?step:-step;
+            evaluate(&simplex[j+1]);
+        }
+        auto byValue=[](const Vertex& a, const Vertex& b){
+            return a.second<b.second;
+        };
+        //c+coefficient*(c-worst), the points along the line through the worst vertex
+        Vertex trial(start, 0.0);
+        Vertex other(start, 0.0);
+        std::vector<double> centroid(d);
+        auto along=[&](double coefficient, Vertex* vertex){
+            for(int j=0; j<d; ++j){
+                vertex->first[j]=centroid[j]+coefficient*(centroid[j]-simplex[d].first[j]);
+            }
+            evaluate(vertex);
+        };
+        while(numEvaluations<maxEvaluations){
+            std::sort(simplex.begin(), simplex.end(), byValue);
+            if(simplex[0].second<=target){
+                break;
+            }
+            double size=0.0;
+            for(int i=1; i<=d; ++i){
+                for(int j=0; j<d; ++j){
+                    size=std::max(size, std::abs(simplex[i].first[j]-simplex[0].first[j])/(ul[j].upper-ul[j].lower));
+                }
+            }
+            if(size<1e-14){
+                break;
+            }
+            std::fill(centroid.begin(), centroid.end(), 0.0);
+            for(int i=0; i<d; ++i){
+                for(int j=0; j<d; ++j){
+                    centroid[j]+=simplex[i].first[j]/d;
+                }
+            }
+            along(1.0, &trial);
+            if(trial.second<simplex[0].second){
+                if(numEvaluations<maxEvaluations){
+                    along(2.0, &other);
+                    if(other.second<trial.second){
+                        std::swap(simplex[d], other);
+                        continue;
+                    }
+                }
+                std::swap(simplex[d], trial);
+                continue;
+            }
+            if(trial.second<simplex[d-1].second){
+                std::swap(simplex[d], trial);
+                continue;
+            }
+            if(numEvaluations>=maxEvaluations){
+                break;
+            }
+            //outside contraction if the reflection beat the worst vertex, inside otherwise
+            const bool outside=trial.second<simplex[d].second;
+            along(outside?.5:-.5, &other);
+            if(other.second<std::min(trial.second, simplex[d].second)){
+                std::swap(simplex[d], other);
+                continue;
+            }
+            for(int i=1; i<=d&&numEvaluations<maxEvaluations; ++i){
+                for(int j=0; j<d; ++j){
+                    simplex[i].first[j]=simplex[0].first[j]+.5*(simplex[i].first[j]-simplex[0].first[j]);
+                }
+                evaluate(&simplex[i]);
+            }
+        }
+        return *std::min_element(simplex.begin(), simplex.end(), byValue);
+    }
+}
+
+#endif
@@ -0,0 +1,23 @@
+#ifndef __SWARM_OBSERVER_H__
+#define __SWARM_OBSERVER_H__
+
+namespace swarm_utils{
+    /**Observer that does nothing.  Optimizers call these hooks on their Observer
+    template parameter, so with the default every call is an empty inline
+    function and compiles away.  A custom observer can derive from this and
+    hide only the hooks it needs.
+    onReplacement reports a member whose position was replaced: an accepted
+    cuckoo egg or a firefly move.  onAbandonment reports a re-randomized nest.*/
+    struct NullObserver{
+        template<typename Population>
+        void onGenerationStart(int iteration, const Population& population){}
+        template<typename Population>
+        void onGenerationEnd(int iteration, const Population& population){}
+        template<typename Params>
+        void onEvaluation(const Params& params, double value){}
+        void onReplacement(int index, double previousValue, double newValue){}
+        void onAbandonment(int index){}
+    };
+}
+
+#endif
@@ -0,0 +1,92 @@
+#ifndef __SWARM_OPPOSITION_H__
+#define __SWARM_OPPOSITION_H__
+#include <vector>
+#include <algorithm>
+#include <utility>
+#include "utils.h"
+
+/**Opposition based learning (Rahnamayan, Tizhoosh and Salama, 2008): the
+opposite of x in [lower, upper] is lower+upper-x.  Evaluating a population
+together with its opposites and keeping the best half covers the box from
+both sides at the cost of n evaluations.*/
+namespace swarm_utils{
+    /**Evaluates opposites[i], the opposite of population[i] in
+    [lower, upper], and leaves the best population.size() of both in
+    population, sorted from best to worst.  opposites is scratch space that
+    is overwritten; once it has the shape of population nothing is
+    allocated.*/
+    template<typename ObjFn>
+    void keepBestOfOpposites(
+        Population* population, Population* opposites,
+        const std::vector<double>& lower, const std::vector<double>& upper, const ObjFn& objFn
+    ){
+        Population& populationRef= *population;
+        Population& oppositesRef= *opposites;
+        const int n=populationRef.size();
+        const int m=lower.size();
+        oppositesRef.resize(n);
+        for(int i=0; i<n; ++i){
+            oppositesRef[i].first.resize(m);
+            for(int j=0; j<m; ++j){
+                oppositesRef[i].first[j]=lower[j]+upper[j]-populationRef[i].first[j];
+            }
+            oppositesRef[i].second=objFn(oppositesRef[i].first);
+        }
+        auto byValue=[](const auto& a, const auto& b){
+            return a.second<b.second;
+        };
+        std::sort(populationRef.begin(), populationRef.end(), byValue);
+        std::sort(oppositesRef.begin(), oppositesRef.end(), byValue);
+        //the best n are the first numKept members and the first n-numKept
+        //opposites; swapping moves the vectors without copying them
+        int numKept=0;
+        for(int taken=0; taken<n; ++taken){
+            numKept+=populationRef[numKept].second<=oppositesRef[taken-numKept].second;
+        }
+        for(int i=numKept; i<n; ++i){
+            std::swap(populationRef[i], oppositesRef[i-numKept]);
+        }
+        std::sort(populationRef.begin(), populationRef.end(), byValue);
+    }
+
+    /**Opposition based initialization: adds the opposites in the box ul
+    of every member of population and keeps the best population.size().
+    Opposites of members outside the box are clamped into it.*/
+    template<typename Array, typename ObjFn>
+    void addOpposites(Population* population, const Array& ul, const ObjFn& objFn){
+        const int m=ul.size();
+        std::vector<double> lower(m);
+        std::vector<double> upper(m);
+        for(int j=0; j<m; ++j){
+            lower[j]=ul[j].lower;
+            upper[j]=ul[j].upper;
+        }
+        Population opposites;
+        keepBestOfOpposites(population, &opposites, lower, upper, [&](std::vector<double>& params){
+            for(int j=0; j<m; ++j){
+                params[j]=getTruncatedParameter(lower[j], upper[j], params[j]);
+            }
+            return objFn(params);
+        });
+    }
+
+    /**Generation jumping: opposites are taken in the smallest box holding
+    the current population rather than in the search box, so the jump
+    shrinks as the population converges*/
+    template<typename ObjFn>
+    void jumpToOpposites(Population* population, Population* opposites, const ObjFn& objFn){
+        const Population& populationRef= *population;
+        const int m=populationRef[0].first.size();
+        std::vector<double> lower(populationRef[0].first);
+        std::vector<double> upper(populationRef[0].first);
+        for(const auto& member:populationRef){
+            for(int j=0; j<m; ++j){
+                lower[j]=std::min(lower[j], member.first[j]);
+                upper[j]=std::max(upper[j], member.first[j]);
+            }
+        }
+        keepBestOfOpposites(population, opposites, lower, upper, objFn);
+    }
+}
+
+#endif
@@ -0,0 +1,197 @@
+#ifndef __SWARM_PROBLEMS_H__
+#define __SWARM_PROBLEMS_H__
+#include <vector>
+#include <string>
+#include <functional>
+#include <cmath>
+#include <algorithm>
+#include "utils.h"
+
+namespace swarm_utils{
+    /**Test function with a known minimum of 0 at optimum.  Points outside
+    bounds are penalized rather than rejected, since cuckoo search can leave
+    the box (new nests are drawn from a normal).*/
+    struct Problem{
+        std::string name;
+        std::vector<upper_lower<double> > bounds;
+        std::vector<double> optimum;
+        std::function<double(const std::vector<double>&)> objective;
+    };
+
+    /**Test functions in the style of BBOB and CEC, each with its minimum of
+    0 at z=0*/
+    namespace problems{
+        const double pi=3.14159265358979323846;
+        inline double sphere(const std::vector<double>& z){
+            double result=0.0;
+            for(const auto& v:z){
+                result+=v*v;
+            }
+            return result;
+        }
+        /**Axis scales from 1 to 1e3, so the condition number is 1e6*/
+        inline double ellipsoid(const std::vector<double>& z){
+            const int d=z.size();
+            double result=0.0;
+            for(int i=0; i<d; ++i){
+                result+=std::pow(1e6, d>1?(double)i/(d-1):0.0)*z[i]*z[i];
+            }
+            return result;
+        }
+        /**Shifted so the minimum is at z=0 rather than at 1*/
+        inline double rosenbrock(const std::vector<double>& z){
+            double result=0.0;
+            for(int i=0; i+1<z.size(); ++i){
+                const double x=z[i]+1;
+                const double y=z[i+1]+1;
+                result+=100*(y-x*x)*(y-x*x)+(1-x)*(1-x);
+            }
+            return result;
+        }
+        inline double rastrigin(const std::vector<double>& z){
+            double result=10.0*z.size();
+            for(const auto& v:z){
+                result+=v*v-10.0*std::cos(2*pi*v);
+            }
+            return result;
+        }
+        inline double ackley(const std::vector<double>& z){
+            double sumSq=0.0;
+            double sumCos=0.0;
+            for(const auto& v:z){
+                sumSq+=v*v;
+                sumCos+=std::cos(2*pi*v);
+            }
+            const double d=z.size();
+            return -20.0*std::exp(-.2*std::sqrt(sumSq/d))-std::exp(sumCos/d)+20.0+std::exp(1.0);
+        }
+        inline double griewank(const std::vector<double>& z){
+            double sumSq=0.0;
+            double product=1.0;
+            for(int i=0; i<z.size(); ++i){
+                sumSq+=z[i]*z[i];
+                product*=std::cos(z[i]/std::sqrt(i+1.0));
+            }
+            return 1.0+sumSq/4000.0-product;
+        }
+        /**Minimum of -x*sin(sqrt(|x|)) on [-500, 500]*/
+        const double schwefelOptimum=420.96874635998202;
+        /**Deceptive: the second best minima are far from the global one.  The
+        usual form is shifted by z=schwefelOptimum so the minimum is at 0.*/
+        inline double schwefel(const std::vector<double>& z){
+            const double minimum=schwefelOptimum*std::sin(std::sqrt(schwefelOptimum));
+            double result=0.0;
+            for(const auto& v:z){
+                const double x=v+schwefelOptimum;
+                result+=minimum-x*std::sin(std::sqrt(std::abs(x)));
+            }
+            return result;
+        }
+
+        /**100 times the squared distance outside the box, as in BBOB*/
+        inline double getBoundaryPenalty(const std::vector<double>& x, const std::vector<upper_lower<double> >& bounds){
+            double result=0.0;
+            for(int i=0; i<x.size(); ++i){
+                const double excess=std::max(0.0, std::max(bounds[i].lower-x[i], x[i]-bounds[i].upper));
+                result+=100*excess*excess;
+            }
+            return result;
+        }
+
+        /**Random orthogonal matrix: Gram-Schmidt on normal draws*/
+        inline std::vector<std::vector<double> > getRotation(int dimension, RandomGenerator* rng){
+            std::vector<std::vector<double> > rotation(dimension, std::vector<double>(dimension));
+            for(int i=0; i<dimension; ++i){
+                auto& row=rotation[i];
+                for(auto& v:row){
+                    v=rng->getNorm();
+                }
+                for(int j=0; j<i; ++j){
+                    double dot=0.0;
+                    for(int k=0; k<dimension; ++k){
+                        dot+=row[k]*rotation[j][k];
+                    }
+                    for(int k=0; k<dimension; ++k){
+                        row[k]-=dot*rotation[j][k];
+                    }
+                }
+                const double norm=std::sqrt(sphere(row));
+                for(auto& v:row){
+                    v/=norm;
+                }
+            }
+            return rotation;
+        }
+
+        /**Problem whose objective is fn(rotation*(x-optimum)), with bounds
+        [lower, upper] in every dimension and the optimum drawn uniformly from
+        the middle 80% of the box.  An empty rotation leaves the axes as they
+        are.*/
+        template<typename Fn>
+        Problem makeProblem(
+            const std::string& name, const Fn& fn, int dimension, double lower, double upper,
+            RandomGenerator* rng, const std::vector<std::vector<double> >& rotation=std::vector<std::vector<double> >()
+        ){
+            Problem problem;
+            problem.name=name;
+            problem.bounds=std::vector<upper_lower<double> >(dimension, upper_lower<double>(double(lower), double(upper)));
+            problem.optimum.resize(dimension);
+            for(auto& v:problem.optimum){
+                v=lower+(upper-lower)*(.1+.8*rng->getUniform());
+            }
+            const auto optimum=problem.optimum;
+            const auto bounds=problem.bounds;
+            problem.objective=[=](const std::vector<double>& x){
+                std::vector<double> shifted(dimension);
+                for(int i=0; i<dimension; ++i){
+                    shifted[i]=x[i]-optimum[i];
+                }
+                if(rotation.empty()){
+                    return fn(shifted)+getBoundaryPenalty(x, bounds);
+                }
+                std::vector<double> z(dimension, 0.0);
+                for(int i=0; i<dimension; ++i){
+                    for(int k=0; k<dimension; ++k){
+                        z[i]+=rotation[i][k]*shifted[k];
+                    }
+                }
+                return fn(z)+getBoundaryPenalty(x, bounds);
+            };
+            return problem;
+        }
+    }
+
+    /**The benchmark set in the given dimension; seed fixes the shifts and
+    rotations, so the same seed always gives the same problems*/
+    inline std::vector<Problem> getProblems(int dimension, int seed){
+        using namespace problems;
+        RandomGenerator rng(seed);
+        std::vector<Problem> result;
+        result.push_back(makeProblem("sphere", sphere, dimension, -5.0, 5.0, &rng));
+        result.push_back(makeProblem("ellipsoid", ellipsoid, dimension, -5.0, 5.0, &rng));
+        result.push_back(makeProblem("rotated ellipsoid", ellipsoid, dimension, -5.0, 5.0, &rng, getRotation(dimension, &rng)));
+        result.push_back(makeProblem("rosenbrock", rosenbrock, dimension, -5.0, 5.0, &rng));
+        result.push_back(makeProblem("rastrigin", rastrigin, dimension, -5.0, 5.0, &rng));
+        result.push_back(makeProblem("rotated rastrigin", rastrigin, dimension, -5.0, 5.0, &rng, getRotation(dimension, &rng)));
+        result.push_back(makeProblem("ackley", ackley, dimension, -32.0, 32.0, &rng));
+        result.push_back(makeProblem("griewank", griewank, dimension, -600.0, 600.0, &rng));
+        //the shift is built into schwefel, whose optimum is near the edge of the box
+        Problem schwefelProblem;
+        schwefelProblem.name="schwefel";
+        schwefelProblem.bounds=std::vector<upper_lower<double> >(dimension, upper_lower<double>{-500.0, 500.0});
+        schwefelProblem.optimum=std::vector<double>(dimension, schwefelOptimum);
+        const auto bounds=schwefelProblem.bounds;
+        //without the penalty, points far outside the box are better than the optimum
+        schwefelProblem.objective=[=](const std::vector<double>& x){
+            std::vector<double> z(x.size());
+            for(int i=0; i<x.size(); ++i){
+                z[i]=x[i]-schwefelOptimum;
+            }
+            return schwefel(z)+getBoundaryPenalty(x, bounds);
+        };
+        result.push_back(schwefelProblem);
+        return result;
+    }
+}
+
+#endif
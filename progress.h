@@ -0,0 +1,92 @@
+#ifndef __SWARM_PROGRESS_H__
+#define __SWARM_PROGRESS_H__
+#include <vector>
+#include <atomic>
+#include <ostream>
+
+namespace swarm_utils{
+    /**Set from any thread to stop an optimization cooperatively; checked by
+    EvaluationBudget before every evaluation*/
+    class CancellationToken{
+    private:
+        std::atomic<bool> cancelled{false};
+    public:
+        void cancel(){
+            cancelled.store(true, std::memory_order_relaxed);
+        }
+        bool isCancelled() const {
+            return cancelled.load(std::memory_order_relaxed);
+        }
+    };
+
+    struct ProgressSnapshot{
+        long long iteration=0;
+        long long evaluations=0;
+        double bestValue=0.0;
+        std::vector<double> bestParameters;
+    };
+
+    /**Latest state of a running optimization, published once per generation
+    and readable from other threads.  Uses a sequence lock: the optimizer
+    never waits, and a reader retries only if it overlaps a publish.*/
+    class Progress{
+    private:
+        std::atomic<unsigned> sequence{0};
+        std::atomic<long long> iteration{0};
+        std::atomic<long long> evaluations{0};
+        std::atomic<double> bestValue{0.0};
+        std::vector<std::atomic<double> > bestParameters;
+    public:
+        explicit Progress(int numParams):bestParameters(numParams){}
+        /**Called by the optimizer thread only*/
+        template<typename Best>
+        void publish(long long iteration_, long long evaluations_, const Best& best){
+            const unsigned start=sequence.load(std::memory_order_relaxed);
+            sequence.store(start+1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            iteration.store(iteration_, std::memory_order_relaxed);
+            evaluations.store(evaluations_, std::memory_order_relaxed);
+            bestValue.store(best.second, std::memory_order_relaxed);
+            for(int i=0; i<bestParameters.size()&&i<best.first.size(); ++i){
+                bestParameters[i].store(best.first[i], std::memory_order_relaxed);
+            }
+            sequence.store(start+2, std::memory_order_release);
+        }
+        /**Consistent copy of the last published state*/
+        void read(ProgressSnapshot* snapshot) const {
+            snapshot->bestParameters.resize(bestParameters.size());
+            while(true){
+                const unsigned start=sequence.load(std::memory_order_acquire);
+                if(start&1){
+                    continue;
+                }
+                snapshot->iteration=iteration.load(std::memory_order_relaxed);
+                snapshot->evaluations=evaluations.load(std::memory_order_relaxed);
+                snapshot->bestValue=bestValue.load(std::memory_order_relaxed);
+                for(int i=0; i<bestParameters.size(); ++i){
+                    snapshot->bestParameters[i]=bestParameters[i].load(std::memory_order_relaxed);
+                }
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if(sequence.load(std::memory_order_relaxed)==start){
+                    return;
+                }
+            }
+        }
+        ProgressSnapshot read() const {
+            ProgressSnapshot snapshot;
+            read(&snapshot);
+            return snapshot;
+        }
+    };
+
+    /**Prints the snapshot in the format of the former VERBOSE_FLAG output*/
+    inline std::ostream& operator<<(std::ostream& out, const ProgressSnapshot& snapshot){
+        out<<"Index: "<<snapshot.iteration<<", Param Vals: ";
+        for(const auto& v:snapshot.bestParameters){
+            out<<v<<", ";
+        }
+        return out<<", Obj Val: "<<snapshot.bestValue;
+    }
+}
+
+#endif
@@ -0,0 +1,110 @@
+#ifndef __SWARM_RESTART_H__
+#define __SWARM_RESTART_H__
+#include <vector>
+#include <utility>
+#include <limits>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <cmath>
+#include <algorithm>
+#include <exception>
+#include "budget.h"
+#include "convergence.h"
+
+namespace swarm_utils{
+    /**IPOP style restarts: each run stops on the convergence criteria and the
+    next one starts with populationGrowth times as many members, up to
+    maxPopulation, and a fresh random stream (seed+run).  numThreads runs
+    execute at once, which requires a thread safe objective and makes the
+    result depend on scheduling; 1, the default, runs them in turn and 0
+    uses every hardware thread.*/
+    struct RestartStrategy{
+        ConvergenceCriteria criteria=ConvergenceCriteria().withStagnation(100, 1e-8);
+        double populationGrowth=2.0;
+        int maxPopulation=1000;
+        int numThreads=1;
+        RestartStrategy& withCriteria(const ConvergenceCriteria& criteria_){
+            criteria=criteria_;
+            return *this;
+        }
+        RestartStrategy& withPopulationGrowth(double populationGrowth_){
+            populationGrowth=populationGrowth_;
+            return *this;
+        }
+        RestartStrategy& withMaxPopulation(int maxPopulation_){
+            maxPopulation=maxPopulation_;
+            return *this;
+        }
+        RestartStrategy& withThreads(int numThreads_){
+            numThreads=numThreads_;
+            return *this;
+        }
+    };
+
+    /**Best point over all runs, and how many runs were started*/
+    struct RestartResult: public std::pair<std::vector<double>, double>{
+        int numRuns=0;
+        long long numEvaluations=0;
+        RestartResult():std::pair<std::vector<double>, double>(std::vector<double>(), std::numeric_limits<double>::infinity()){}
+    };
+
+    /**Runs makeOptimizer(n, seed, budget) with growing n until totalEvaluations,
+    shared by all runs, are used up or a run reaches tol.  The optimizer must
+    provide setConvergence, step, best and evaluations, as cuckoo::Optimizer and
+    firefly::Optimizer do.  If a run throws, the other runs are stopped and
+    the first exception is rethrown once every thread has finished.*/
+    template<typename MakeOptimizer>
+    RestartResult runRestarts(const MakeOptimizer& makeOptimizer, int n, long long totalEvaluations, double tol, int seed, const RestartStrategy& strategy){
+        std::atomic<long long> pool(totalEvaluations);
+        std::atomic<int> nextRun(0);
+        std::mutex resultMutex;
+        RestartResult result;
+        std::exception_ptr error;
+        auto worker=[&](){
+            try{
+                while(pool.load()>0){
+                    const int run=nextRun++;
+                    //capped before the conversion, since the growth overflows an int after a few dozen runs
+                    const int numMembers=(int)std::round(std::min(n*std::pow(strategy.populationGrowth, run), (double)std::max(n, strategy.maxPopulation)));
+                    auto optimizer=makeOptimizer(numMembers, seed+run, EvaluationBudget().withSharedPool(&pool));
+                    optimizer.setConvergence(strategy.criteria);
+                    while(optimizer.step()){}
+                    std::lock_guard<std::mutex> lock(resultMutex);
+                    ++result.numRuns;
+                    result.numEvaluations+=optimizer.evaluations();
+                    if(optimizer.best().second<result.second){
+                        result.first=optimizer.best().first;
+                        result.second=optimizer.best().second;
+                    }
+                    if(result.second<=tol){
+                        pool=0;//stops the runs still in progress
+                    }
+                }
+            }catch(...){
+                //an exception escaping a std::thread calls std::terminate
+                std::lock_guard<std::mutex> lock(resultMutex);
+                if(!error){
+                    error=std::current_exception();
+                }
+                pool=0;
+            }
+        };
+        //hardware_concurrency is 0 when it cannot be determined
+        const int numThreads=strategy.numThreads>0?strategy.numThreads:std::max(1u, std::thread::hardware_concurrency());
+        std::vector<std::thread> threads;
+        for(int i=1; i<numThreads; ++i){
+            threads.emplace_back(worker);
+        }
+        worker();
+        for(auto& thread:threads){
+            thread.join();
+        }
+        if(error){
+            std::rethrow_exception(error);
+        }
+        return result;
+    }
+}
+
+#endif
@@ -0,0 +1,208 @@
+#ifndef __SWARM_SAMPLING_H__
+#define __SWARM_SAMPLING_H__
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include <utility>
+#include "utils.h"
+
+namespace swarm_utils{
+    /**Initial population policies: sampler(n, dimension, unif) returns n
+    points of [0, 1)^dimension, drawing from the uniform generator unif.  All
+    points are generated at once, so they cover the cube together rather than
+    independently as getRandomParameters does (whose normal draws also
+    cluster around the centre).  Each sequence is randomized by unif, so
+    different seeds give different, equally well spread, points.*/
+
+    /**Halton sequence: dimension j is the radical inverse of the index in the
+    j-th prime base, shifted by a uniform draw modulo 1 (Cranley-Patterson
+    rotation).  Fine for a handful of dimensions; in high dimension the large
+    bases correlate for small n, prefer SobolSampling there.*/
+    struct HaltonSampling{
+        template<typename Unif>
+        std::vector<std::vector<double> > operator()(int n, int dimension, const Unif& unif) const {
+            std::vector<int> bases;
+            for(int candidate=2; bases.size()<dimension; ++candidate){
+                bool isPrime=true;
+                for(const auto& base:bases){
+                    if(base*base>candidate){
+                        break;
+                    }
+                    isPrime=isPrime&&candidate%base!=0;
+                }
+                if(isPrime){
+                    bases.push_back(candidate);
+                }
+            }
+            std::vector<double> shifts(dimension);
+            for(auto& shift:shifts){
+                shift=unif();
+            }
+            std::vector<std::vector<double> > points(n, std::vector<double>(dimension));
+            for(int j=0; j<dimension; ++j){
+                const int base=bases[j];
+                for(int i=0; i<n; ++i){
+                    double value=0.0;
+                    double scale=1.0/base;
+                    for(int index=i+1; index>0; index/=base){
+                        value+=(index%base)*scale;
+                        scale/=base;
+                    }
+                    value+=shifts[j];
+                    points[i][j]=value>=1.0?value-1.0:value;
+                }
+            }
+            return points;
+        }
+    };
+
+    /**Sobol sequence in Gray code order with a random digital shift (each
+    coordinate is XORed with a uniform 32 bit integer, which keeps every
+    elementary interval filled).  The first 21 dimensions use the direction
+    numbers of Joe and Kuo (2008); later dimensions use further primitive
+    polynomials with all initial direction numbers 1, which are valid but
+    less uniform in low dimensional projections.*/
+    struct SobolSampling{
+        static constexpr int numBits=32;
+        /**Degree, coefficients and initial direction numbers of dimensions
+        2 to 21 (new-joe-kuo-6.21201)*/
+        static const std::vector<std::pair<std::pair<int, int>, std::vector<uint32_t> > >& getDirectionTable(){
+            static const std::vector<std::pair<std::pair<int, int>, std::vector<uint32_t> > > table={
+                {{1, 0}, {1}}, {{2, 1}, {1, 3}}, {{3, 1}, {1, 3, 1}}, {{3, 2}, {1, 1, 1}},
+                {{4, 1}, {1, 1, 3, 3}}, {{4, 4}, {1, 3, 5, 13}}, {{5, 2}, {1, 1, 5, 5, 17}},
+                {{5, 4}, {1, 1, 5, 5, 5}}, {{5, 7}, {1, 1, 7, 11, 19}}, {{5, 11}, {1, 1, 5, 1, 1}},
+                {{5, 13}, {1, 1, 1, 3, 11}}, {{5, 14}, {1, 3, 5, 5, 31}}, {{6, 1}, {1, 3, 3, 9, 7, 49}},
+                {{6, 13}, {1, 1, 1, 15, 21, 21}}, {{6, 16}, {1, 3, 1, 13, 27, 49}}, {{6, 19}, {1, 1, 1, 15, 7, 5}},
+                {{6, 22}, {1, 3, 1, 15, 13, 25}}, {{6, 25}, {1, 1, 5, 5, 19, 61}},
+                {{7, 1}, {1, 3, 7, 11, 23, 15, 103}}, {{7, 4}, {1, 3, 7, 13, 13, 15, 69}}
+            };
+            return table;
+        }
+        /**Whether x^degree+(coefficients<<1)+1 is primitive over GF(2),
+        that is whether x has order 2^degree-1 modulo it*/
+        static bool isPrimitive(int degree, int coefficients){
+            const uint64_t polynomial=(1ull<<degree)|((uint64_t)coefficients<<1)|1ull;
+            const uint64_t order=(1ull<<degree)-1;
+            uint64_t power=1;
+            for(uint64_t k=1; k<=order; ++k){
+                power<<=1;
+                if(power>>degree&1){
+                    power^=polynomial;
+                }
+                if(power==1){
+                    return k==order;
+                }
+            }
+            return false;
+        }
+        /**Direction numbers V[1..numBits], scaled to 32 bits, of the
+        dimension with the given primitive polynomial*/
+        static std::vector<uint32_t> getDirections(int degree, int coefficients, const std::vector<uint32_t>& initial){
+            std::vector<uint32_t> directions(numBits+1, 0);
+            for(int i=1; i<=numBits; ++i){
+                if(i<=degree){
+                    directions[i]=initial[i-1]<<(numBits-i);
+                    continue;
+                }
+                uint32_t value=directions[i-degree]^(directions[i-degree]>>degree);
+                for(int k=1; k<degree; ++k){
+                    value^=((coefficients>>(degree-1-k))&1)*directions[i-k];
+                }
+                directions[i]=value;
+            }
+            return directions;
+        }
+        template<typename Unif>
+        std::vector<std::vector<double> > operator()(int n, int dimension, const Unif& unif) const {
+            //the first dimension is the van der Corput sequence in base 2
+            std::vector<std::vector<uint32_t> > directions(1, std::vector<uint32_t>(numBits+1, 0));
+            for(int i=1; i<=numBits; ++i){
+                directions[0][i]=1u<<(numBits-i);
+            }
+            const auto& table=getDirectionTable();
+            int degree=table.back().first.first;
+            int coefficients=table.back().first.second;
+            for(int j=1; j<dimension; ++j){
+                if(j-1<table.size()){
+                    const auto& entry=table[j-1];
+                    directions.push_back(getDirections(entry.first.first, entry.first.second, entry.second));
+                    continue;
+                }
+                //next primitive polynomial after the last one used
+                do{
+                    ++coefficients;
+                    if(coefficients>=(1<<(degree-1))){
+                        ++degree;
+                        coefficients=0;
+                    }
+                }while(!isPrimitive(degree, coefficients));
+                directions.push_back(getDirections(degree, coefficients, std::vector<uint32_t>(degree, 1)));
+            }
+            std::vector<uint32_t> shifts(dimension);
+            for(auto& shift:shifts){
+                shift=(uint32_t)std::min(unif()*4294967296.0, 4294967295.0);
+            }
+            const double scale=1.0/4294967296.0;
+            std::vector<std::vector<double> > points(n, std::vector<double>(dimension));
+            std::vector<uint32_t> current(dimension, 0);
+            for(int i=0; i<n; ++i){
+                for(int j=0; j<dimension; ++j){
+                    points[i][j]=(current[j]^shifts[j])*scale;
+                }
+                //Gray code: flip the direction of the lowest zero bit of i
+                int bit=1;
+                for(uint32_t index=i; index&1; index>>=1){
+                    ++bit;
+                }
+                for(int j=0; j<dimension; ++j){
+                    current[j]^=directions[j][std::min(bit, (int)numBits)];
+                }
+            }
+            return points;
+        }
+    };
+
+    /**Latin hypercube: each dimension is cut into n equal strata and every
+    stratum gets exactly one point, at a uniform position within it.  The
+    strata are matched across dimensions by random permutations.*/
+    struct LatinHypercubeSampling{
+        template<typename Unif>
+        std::vector<std::vector<double> > operator()(int n, int dimension, const Unif& unif) const {
+            std::vector<std::vector<double> > points(n, std::vector<double>(dimension));
+            std::vector<int> strata(n);
+            for(int j=0; j<dimension; ++j){
+                for(int i=0; i<n; ++i){
+                    strata[i]=i;
+                }
+                //Fisher-Yates
+                for(int i=n-1; i>0; --i){
+                    std::swap(strata[i], strata[std::min(i, (int)(unif()*(i+1)))]);
+                }
+                for(int i=0; i<n; ++i){
+                    //unif is on (0, 1], so 1-unif is on [0, 1)
+                    points[i][j]=(strata[i]+1.0-unif())/n;
+                }
+            }
+            return points;
+        }
+    };
+
+    /**Population of n members sampled by sampler and scaled into the bounds
+    ul, evaluated after all points are generated*/
+    template<typename Array, typename Sampler, typename ObjFn, typename Unif>
+    Population getSampledPopulation(const Array& ul, const Sampler& sampler, const ObjFn& objFn, const Unif& unif, int n){
+        const int dimension=ul.size();
+        auto points=sampler(n, dimension, unif);
+        Population population(n);
+        for(int i=0; i<n; ++i){
+            for(int j=0; j<dimension; ++j){
+                points[i][j]=ul[j].lower+(ul[j].upper-ul[j].lower)*points[i][j];
+            }
+            population[i].first=std::move(points[i]);
+            population[i].second=objFn(population[i].first);
+        }
+        return population;
+    }
+}
+
+#endif
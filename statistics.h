@@ -0,0 +1,76 @@
+#ifndef __SWARM_STATISTICS_H__
+#define __SWARM_STATISTICS_H__
+#include <vector>
+#include <utility>
+#include <chrono>
+#include <thread>
+#include <cstdint>
+#if defined(__x86_64__)||defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace swarm_utils{
+    /**Cycle counter where available (rdtsc, a few nanoseconds per read),
+    otherwise steady_clock nanoseconds*/
+    inline uint64_t readTicks(){
+        #if defined(__x86_64__)||defined(__i386__)
+            return __rdtsc();
+        #else
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()
+            ).count();
+        #endif
+    }
+    /**Measured once, against steady_clock, on first use*/
+    inline double getTicksPerSecond(){
+        static const double ticksPerSecond=[](){
+            const auto start=std::chrono::steady_clock::now();
+            const uint64_t startTicks=readTicks();
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            const uint64_t endTicks=readTicks();
+            const std::chrono::duration<double> elapsed=std::chrono::steady_clock::now()-start;
+            return (endTicks-startTicks)/elapsed.count();
+        }();
+        return ticksPerSecond;
+    }
+
+    /**Where an optimization spent its time, in readTicks units.  Generation is
+    the time spent creating candidates (levy flights or firefly moves), sorting
+    includes merging the new nests into the ranked population and abandonment
+    is the time spent re-randomizing nests; none include the objective.
+    Surrogate is the time spent fitting and querying the surrogate model and
+    screenedEvaluations the candidates it rejected without evaluating them.
+    Refinement is the local search of the hybrid mode, which used
+    refinementEvaluations of the evaluations.*/
+    struct RunStatistics{
+        int iterations=0;
+        long long evaluations=0;
+        long long improvingReplacements=0;
+        uint64_t evaluationTicks=0;
+        uint64_t generationTicks=0;
+        uint64_t sortTicks=0;
+        uint64_t abandonmentTicks=0;
+        long long screenedEvaluations=0;
+        uint64_t surrogateTicks=0;
+        long long refinementEvaluations=0;
+        uint64_t refinementTicks=0;
+        static double seconds(uint64_t ticks){
+            return ticks/getTicksPerSecond();
+        }
+        /**Share of the measured time spent in the objective*/
+        double evaluationFraction() const {
+            const uint64_t total=evaluationTicks+generationTicks+sortTicks+abandonmentTicks+surrogateTicks+refinementTicks;
+            return total>0?(double)evaluationTicks/total:0.0;
+        }
+    };
+
+    /**Best point of a run together with its statistics; can be used wherever
+    the plain pair was*/
+    struct OptimizeResult: public std::pair<std::vector<double>, double>{
+        RunStatistics statistics;
+        OptimizeResult(const std::pair<std::vector<double>, double>& best, const RunStatistics& statistics_):
+            std::pair<std::vector<double>, double>(best), statistics(statistics_){}
+    };
+}
+
+#endif
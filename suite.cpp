@@ -0,0 +1,193 @@
+/**Black box benchmark of cuckoo search (with fixed and with adaptive
+parameters) and the firefly algorithm on the problems of problems.h.  Every algorithm, problem and dimension is run from
+numSeeds seeds, spread over all hardware threads.  A run stops once it
+reaches target or uses maxEvaluations; reported are the success rate, the
+median evaluations to target of the successful runs, the expected running
+time (all evaluations over all runs divided by the number of successes, as
+in BBOB), the median final value and the mean wall clock time per run.
+
+Usage: suite [output.json] [numSeeds]*/
+#include <iostream>
+#include <fstream>
+#include <chrono>
+#include <algorithm>
+#include <limits>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <cstdlib>
+#include "cuckoo.h"
+#include "firefly.h"
+#include "problems.h"
+
+namespace {
+    const double target=1e-6;
+    const long long evaluationsPerDimension=10000;
+    const int populationSize=25;
+
+    struct Run{
+        bool success=false;
+        long long evaluationsToTarget=0;
+        long long evaluations=0;
+        double value=0.0;
+        double seconds=0.0;
+    };
+    struct Summary{
+        std::string algorithm;
+        std::string problem;
+        int dimension;
+        std::vector<Run> runs;
+    };
+
+    /**Steps the optimizer until an evaluation reaches target or the budget of
+    maxEvaluations runs out*/
+    template<typename MakeOptimizer>
+    Run runToTarget(const swarm_utils::Problem& problem, const MakeOptimizer& makeOptimizer, long long maxEvaluations, int seed){
+        Run run;
+        long long numEvaluations=0;
+        long long hitAt=-1;
+        auto objective=[&](const std::vector<double>& params){
+            const double value=problem.objective(params);
+            ++numEvaluations;
+            if(hitAt<0&&value<=target){
+                hitAt=numEvaluations;
+            }
+            return value;
+        };
+        const auto start=std::chrono::steady_clock::now();
+        auto optimizer=makeOptimizer(objective, problem.bounds, seed, swarm_utils::EvaluationBudget().withMaxEvaluations(maxEvaluations));
+        while(hitAt<0&&optimizer.step()){}
+        run.seconds=std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+        run.success=hitAt>=0;
+        run.evaluationsToTarget=hitAt;
+        run.evaluations=run.success?hitAt:numEvaluations;
+        run.value=optimizer.best().second;
+        return run;
+    }
+
+    double median(std::vector<double> values){
+        if(values.empty()){
+            return std::numeric_limits<double>::quiet_NaN();
+        }
+        std::sort(values.begin(), values.end());
+        return values[values.size()/2];
+    }
+    /**NaN and infinity are not valid JSON*/
+    void writeNumber(std::ostream& out, double value){
+        if(std::isfinite(value)){
+            out<<value;
+        }
+        else{
+            out<<"null";
+        }
+    }
+    void writeJson(std::ostream& out, int numSeeds, const std::vector<Summary>& summaries){
+        out<<"{\n  \"target\": "<<target<<",\n  \"evaluationsPerDimension\": "<<evaluationsPerDimension;
+        out<<",\n  \"seeds\": "<<numSeeds<<",\n  \"results\": [\n";
+        for(int i=0; i<summaries.size(); ++i){
+            const Summary& s=summaries[i];
+            int numSuccesses=0;
+            long long totalEvaluations=0;
+            double totalSeconds=0.0;
+            std::vector<double> evaluationsToTarget;
+            std::vector<double> values;
+            for(const auto& run:s.runs){
+                numSuccesses+=run.success;
+                totalEvaluations+=run.evaluations;
+                totalSeconds+=run.seconds;
+                values.push_back(run.value);
+                if(run.success){
+                    evaluationsToTarget.push_back(run.evaluationsToTarget);
+                }
+            }
+            out<<"    {\"algorithm\": \""<<s.algorithm<<"\", \"problem\": \""<<s.problem<<"\", \"dimension\": "<<s.dimension;
+            out<<", \"successRate\": "<<(double)numSuccesses/s.runs.size();
+            out<<", \"medianEvaluationsToTarget\": ";
+            writeNumber(out, median(evaluationsToTarget));
+            out<<", \"expectedRunningTime\": ";
+            writeNumber(out, numSuccesses>0?(double)totalEvaluations/numSuccesses:std::numeric_limits<double>::infinity());
+            out<<", \"medianValue\": ";
+            writeNumber(out, median(values));
+            out<<", \"meanSeconds\": "<<totalSeconds/s.runs.size()<<"}"<<(i+1<summaries.size()?",":"")<<"\n";
+        }
+        out<<"  ]\n}\n";
+    }
+}
+
+int main(int argc, char** argv){
+    const int numSeeds=argc>2?std::atoi(argv[2]):15;
+    auto makeCuckoo=[](const auto& objective, const auto& ul, int seed, const swarm_utils::EvaluationBudget& budget){
+        //the getPA schedule is spread over the whole budget
+        const long long maxEvaluations=evaluationsPerDimension*ul.size();
+        return cuckoo::makeOptimizer(objective, ul, populationSize, maxEvaluations/populationSize, target, seed, budget);
+    };
+    auto makeAdaptiveCuckoo=[&](const auto& objective, const auto& ul, int seed, const swarm_utils::EvaluationBudget& budget){
+        auto optimizer=makeCuckoo(objective, ul, seed, budget);
+        optimizer.setAdaptive(true);
+        return optimizer;
+    };
+    auto makeFirefly=[](const auto& objective, const auto& ul, int seed, const swarm_utils::EvaluationBudget& budget){
+        const long long maxEvaluations=evaluationsPerDimension*ul.size();
+        return firefly::makeOptimizer(objective, ul, maxEvaluations/populationSize, seed, firefly::AllPairsUpdate(), budget);
+    };
+    //one job per algorithm, problem, dimension and seed
+    struct Job{
+        int summary;
+        int set;
+        int problem;
+        int seed;
+        int algorithm;
+    };
+    const std::vector<std::string> algorithms={"cuckoo", "cuckoo-adaptive", "firefly"};
+    std::vector<Summary> summaries;
+    std::vector<std::vector<swarm_utils::Problem> > problemSets;
+    std::vector<Job> jobs;
+    for(int dimension:{2, 5, 10}){
+        problemSets.push_back(swarm_utils::getProblems(dimension, 2018));
+        const int set=problemSets.size()-1;
+        for(int p=0; p<problemSets[set].size(); ++p){
+            for(int algorithm=0; algorithm<algorithms.size(); ++algorithm){
+                summaries.push_back(Summary{algorithms[algorithm], problemSets[set][p].name, dimension, std::vector<Run>(numSeeds)});
+                for(int seed=0; seed<numSeeds; ++seed){
+                    jobs.push_back(Job{(int)summaries.size()-1, set, p, seed, algorithm});
+                }
+            }
+        }
+    }
+    std::atomic<int> nextJob(0);
+    auto worker=[&](){
+        for(int j=nextJob++; j<jobs.size(); j=nextJob++){
+            const Job& job=jobs[j];
+            const auto& problem=problemSets[job.set][job.problem];
+            const long long maxEvaluations=evaluationsPerDimension*problem.bounds.size();
+            Run& run=summaries[job.summary].runs[job.seed];
+            switch(job.algorithm){
+                case 0:
+                    run=runToTarget(problem, makeCuckoo, maxEvaluations, job.seed);
+                    break;
+                case 1:
+                    run=runToTarget(problem, makeAdaptiveCuckoo, maxEvaluations, job.seed);
+                    break;
+                default:
+                    run=runToTarget(problem, makeFirefly, maxEvaluations, job.seed);
+            }
+        }
+    };
+    std::vector<std::thread> threads;
+    for(int i=1; i<std::max(1u, std::thread::hardware_concurrency()); ++i){
+        threads.emplace_back(worker);
+    }
+    worker();
+    for(auto& thread:threads){
+        thread.join();
+    }
+    if(argc>1){
+        std::ofstream out(argv[1]);
+        writeJson(out, numSeeds, summaries);
+    }
+    else{
+        writeJson(std::cout, numSeeds, summaries);
+    }
+    return 0;
+}
@@ -0,0 +1,148 @@
+#ifndef __SWARM_SURROGATE_H__
+#define __SWARM_SURROGATE_H__
+#include <vector>
+#include <cmath>
+#include <algorithm>
+
+namespace swarm_utils{
+    /**Cubic radial basis function interpolant with a linear tail, fit to the
+    last capacity evaluated points:
+        s(x)=sum_i w_i |x-x_i|^3 + c_0 + sum_k c_k x_k
+    Fitting solves the dense (N+d+1) system by Gaussian elimination, O(N^3)
+    for N points, and a prediction is O(N d).  The buffers are kept between
+    fits, so nothing is allocated once the archive is full.*/
+    class RbfSurrogate{
+    private:
+        std::vector<double> points; //row major, capacity x numParams
+        std::vector<double> values;
+        std::vector<double> system;
+        std::vector<double> coefficients;
+        int capacity;
+        int numParams=0;
+        int numPoints=0;
+        int next=0;
+        bool fitted=false;
+        template<typename Params>
+        double getCubedDistance(const Params& params, int i) const {
+            double r=0.0;
+            for(int k=0; k<numParams; ++k){
+                const double diff=params[k]-points[i*numParams+k];
+                r+=diff*diff;
+            }
+            return r*std::sqrt(r);
+        }
+        double getCubedDistance(int i, int j) const {
+            return getCubedDistance(&points[i*numParams], j);
+        }
+    public:
+        explicit RbfSurrogate(int capacity_=100):capacity(capacity_){}
+        /**Adds an evaluated point, replacing the oldest once full.  Exact
+        duplicates and non finite values are ignored, since they would make
+        the system singular.*/
+        template<typename Params>
+        void add(const Params& params, double value){
+            if(!std::isfinite(value)){
+                return;
+            }
+            if(numParams==0){
+                numParams=params.size();
+                points.resize(capacity*numParams);
+                values.resize(capacity);
+            }
+            for(int i=0; i<numPoints; ++i){
+                if(std::equal(params.begin(), params.end(), points.begin()+i*numParams)){
+                    return;
+                }
+            }
+            std::copy(params.begin(), params.end(), points.begin()+next*numParams);
+            values[next]=value;
+            next=(next+1)%capacity;
+            numPoints=std::min(numPoints+1, capacity);
+            fitted=false;
+        }
+        int size() const {
+            return numPoints;
+        }
+        /**Whether the last fit succeeded and no points were added since*/
+        bool ready() const {
+            return fitted;
+        }
+        /**Solves for the weights; false if there are fewer than d+2 points or
+        the system is numerically singular*/
+        bool fit(){
+            fitted=false;
+            if(numParams==0||numPoints<numParams+2){
+                return false;
+            }
+            const int s=numPoints+numParams+1;
+            system.assign(s*s, 0.0);
+            coefficients.assign(s, 0.0);
+            double scale=0.0;
+            for(int i=0; i<numPoints; ++i){
+                for(int j=0; j<numPoints; ++j){
+                    system[i*s+j]=getCubedDistance(i, j);
+                    scale=std::max(scale, system[i*s+j]);
+                }
+                system[i*s+numPoints]=1.0;
+                system[numPoints*s+i]=1.0;
+                for(int k=0; k<numParams; ++k){
+                    system[i*s+numPoints+1+k]=points[i*numParams+k];
+                    system[(numPoints+1+k)*s+i]=points[i*numParams+k];
+                    scale=std::max(scale, std::abs(points[i*numParams+k]));
+                }
+                coefficients[i]=values[i];
+            }
+            //Gaussian elimination with partial pivoting
+            for(int c=0; c<s; ++c){
+                int pivot=c;
+                for(int r=c+1; r<s; ++r){
+                    pivot=std::abs(system[r*s+c])>std::abs(system[pivot*s+c])?r:pivot;
+                }
+                if(!(std::abs(system[pivot*s+c])>1e-13*scale)){
+                    return false;
+                }
+                if(pivot!=c){
+                    std::swap_ranges(system.begin()+c*s+c, system.begin()+c*s+s, system.begin()+pivot*s+c);
+                    std::swap(coefficients[c], coefficients[pivot]);
+                }
+                const double inverse=1.0/system[c*s+c];
+                for(int r=c+1; r<s; ++r){
+                    const double factor=system[r*s+c]*inverse;
+                    if(factor==0.0){
+                        continue;
+                    }
+                    for(int j=c; j<s; ++j){
+                        system[r*s+j]-=factor*system[c*s+j];
+                    }
+                    coefficients[r]-=factor*coefficients[c];
+                }
+            }
+            for(int r=s-1; r>=0; --r){
+                double sum=coefficients[r];
+                for(int j=r+1; j<s; ++j){
+                    sum-=system[r*s+j]*coefficients[j];
+                }
+                coefficients[r]=sum/system[r*s+r];
+                if(!std::isfinite(coefficients[r])){
+                    return false;
+                }
+            }
+            fitted=true;
+            return true;
+        }
+        /**Value of the interpolant at params; only meaningful when ready()*/
+        template<typename Params>
+        double predict(const Params& params) const {
+            double result=coefficients[numPoints];
+            for(int k=0; k<numParams; ++k){
+                result+=coefficients[numPoints+1+k]*params[k];
+            }
+            for(int i=0; i<numPoints; ++i){
+                result+=coefficients[i]*getCubedDistance(params, i);
+            }
+            return result;
+        }
+    };
+}
+
+#endif
@@ -1,8 +1,59 @@
 #define CATCH_CONFIG_MAIN  // This tells Catch to provide a main() - only do this in one cpp file
 #include "catch.hpp"
 #include <iostream>
+#include <chrono>
+#include <algorithm>
 #include "firefly.h"
 #include "cuckoo.h"
+#include "cache.h"
+#include "evaluation_store.h"
+#include "checkpoint.h"
+#include "budget.h"
+#include "convergence.h"
+#include "restart.h"
+#include "progress.h"
+#include "observer.h"
+#include "statistics.h"
+#include "trace.h"
+#include "problems.h"
+#include "boundary.h"
+#include "sampling.h"
+#include "opposition.h"
+#include "surrogate.h"
+#include "localsearch.h"
+#include <thread>
+#include <limits>
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+#include <cstring>
+#include <type_traits>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+
+/**Expected running time over seeds 0 to numSeeds-1: all the evaluations
+of every run per run that reached target, or infinity if none did.
+makeOptimizer(seed) returns a cuckoo::Optimizer or firefly::Optimizer,
+which is stepped until it is done or reaches target; onRun(optimizer) is
+called after each run.*/
+template<typename MakeOptimizer, typename OnRun>
+double getExpectedRunningTime(const MakeOptimizer& makeOptimizer, int numSeeds, double target, const OnRun& onRun){
+    long long total=0;
+    int numSuccesses=0;
+    for(int seed=0; seed<numSeeds; ++seed){
+        auto optimizer=makeOptimizer(seed);
+        while(optimizer.step()&&optimizer.best().second>target){}
+        total+=optimizer.evaluations();
+        numSuccesses+=optimizer.best().second<=target;
+        onRun(optimizer);
+    }
+    return numSuccesses>0?(double)total/numSuccesses:std::numeric_limits<double>::infinity();
+}
+template<typename MakeOptimizer>
+double getExpectedRunningTime(const MakeOptimizer& makeOptimizer, int numSeeds, double target){
+    return getExpectedRunningTime(makeOptimizer, numSeeds, target, [](const auto& optimizer){});
+}
 
 TEST_CASE("Test Simple Function", "[Cuckoo]"){
     std::vector<swarm_utils::upper_lower<double> > ul;
@@ -163,19 +214,1540 @@ TEST_CASE("Test Rastigrin Function FireFly", "[FireFly]"){
     ul.push_back(bounds);
     ul.push_back(bounds);
     ul.push_back(bounds);
-    int n=ul.size();
-    auto results=firefly::optimize([](const std::vector<double>& inputs){
+    //firefly escapes the local minima for only part of the seeds, so run
+    //several: every run must end near an integer point (each coordinate off
+    //the origin costs about one) and at least one must find the origin
+    double best=std::numeric_limits<double>::infinity();
+    for(int seed=40; seed<50; ++seed){
+        auto results=firefly::optimize([](const std::vector<double>& inputs){
+            return rastigrinScale*inputs.size()+futilities::sum(inputs, [](const auto& val, const auto& index){
+                return futilities::const_power(val, 2)-rastigrinScale*cos(2*M_PI*val);
+            });
+        }, ul, 1000, seed);
+        auto params=std::get<swarm_utils::optparms>(results);
+        for(auto& v:params){
+            REQUIRE(std::abs(v-std::round(v))<.05);
+        }
+        REQUIRE(std::get<swarm_utils::fnval>(results)<3.0);
+        best=std::min(best, std::get<swarm_utils::fnval>(results));
+    }
+    std::cout<<"Firefly Rastigrin:"<<best<<std::endl;
+    REQUIRE(best==Approx(0.0));
+}  
+TEST_CASE("Test KdTree nearest matches brute force", "[KdTree]"){
+    std::vector<std::pair<std::vector<double>, double> > population;
+    srand(42);
+    for(int i=0; i<60; ++i){
+        std::vector<double> params={swarm_utils::getUniform(), swarm_utils::getUniform(), swarm_utils::getUniform()};
+        population.emplace_back(params, (double)i);
+    }
+    swarm_utils::KdTree tree;
+    tree.rebuild(population);
+    std::vector<int> neighbours;
+    for(int i=0; i<60; ++i){
+        auto accept=[&](int j){return population[j].second<population[i].second;};
+        tree.nearest(population[i].first, 4, accept, &neighbours);
+        std::vector<std::pair<double, int> > expected;
+        for(int j=0; j<60; ++j){
+            if(accept(j)){
+                expected.emplace_back(firefly::getDistanceSq(population[i].first, population[j].first), j);
+            }
+        }
+        std::sort(expected.begin(), expected.end());
+        REQUIRE(neighbours.size()==std::min(4, (int)expected.size()));
+        for(int j=0; j<neighbours.size(); ++j){
+            REQUIRE(neighbours[j]==expected[j].second);
+        }
+    }
+}
+
+TEST_CASE("Test Simple Function Firefly Nearest", "[FireFly]"){
+    std::vector<swarm_utils::upper_lower<double> > ul;
+    swarm_utils::upper_lower<double> bounds={-4.0, 4.0};
+    ul.push_back(bounds);
+    ul.push_back(bounds);
+    ul.push_back(bounds);
+    int numEvaluations=0;
+    int maxMC=1000;
+    auto start=std::chrono::steady_clock::now();
+    auto results=firefly::optimizeNearest([&](const std::vector<double>& inputs){
+        ++numEvaluations;
+        return inputs[0]*inputs[0]+inputs[1]*inputs[1]+inputs[2]*inputs[2];
+    }, ul, maxMC, 3, 42);
+    std::chrono::duration<double, std::micro> elapsed=std::chrono::steady_clock::now()-start;
+    std::cout<<"Firefly nearest simple: "<<elapsed.count()/maxMC<<" us per generation, "<<numEvaluations<<" evaluations"<<std::endl;
+    REQUIRE(std::get<swarm_utils::fnval>(results)==Approx(0.0));
+}
+
+TEST_CASE("Test Rosenbrok Function FireFly Nearest", "[FireFly]"){
+    std::vector<swarm_utils::upper_lower<double> > ul;
+    swarm_utils::upper_lower<double> bounds={-4.0, 4.0};
+    ul.push_back(bounds);
+    ul.push_back(bounds);
+    int numEvaluations=0;
+    int maxMC=1000;
+    auto start=std::chrono::steady_clock::now();
+    auto results=firefly::optimizeNearest([&](const std::vector<double>& inputs){
+        ++numEvaluations;
+        return futilities::const_power(1-inputs[0], 2)+100*futilities::const_power(inputs[1]-futilities::const_power(inputs[0], 2), 2);
+    }, ul, maxMC, 3, 42);
+    std::chrono::duration<double, std::micro> elapsed=std::chrono::steady_clock::now()-start;
+    std::cout<<"Firefly nearest Rosenbrok: "<<elapsed.count()/maxMC<<" us per generation, "<<numEvaluations<<" evaluations"<<std::endl;
+    REQUIRE(std::get<swarm_utils::fnval>(results)==Approx(0.0));
+}
+
+TEST_CASE("Test Rastigrin Function FireFly Nearest", "[FireFly]"){
+    std::vector<swarm_utils::upper_lower<double> > ul;
+    swarm_utils::upper_lower<double> bounds={-4.0, 4.0};
+    ul.push_back(bounds);
+    ul.push_back(bounds);
+    ul.push_back(bounds);
+    ul.push_back(bounds);
+    int numEvaluations=0;
+    int maxMC=1000;
+    auto start=std::chrono::steady_clock::now();
+    auto results=firefly::optimizeNearest([&](const std::vector<double>& inputs){
+        ++numEvaluations;
         return rastigrinScale*inputs.size()+futilities::sum(inputs, [](const auto& val, const auto& index){
             return futilities::const_power(val, 2)-rastigrinScale*cos(2*M_PI*val);
         });
-    }, ul, 1000, 42);
-
-    auto params=std::get<swarm_utils::optparms>(results);
-    std::cout<<"Firefly Rastigrin:"<<std::endl;
-    for(auto& v:params){
-        std::cout<<v<<",";
+    }, ul, maxMC, 3, 42);
+    std::chrono::duration<double, std::micro> elapsed=std::chrono::steady_clock::now()-start;
+    std::cout<<"Firefly nearest Rastigrin: "<<elapsed.count()/maxMC<<" us per generation, "<<numEvaluations<<" evaluations, obj fn: "<<std::get<swarm_utils::fnval>(results)<<std::endl;
+    //only k=3 neighbours, so it may settle in a local minimum, but it has to
+    //settle in one: every parameter close to an integer and the value small
+    for(const auto& v:std::get<swarm_utils::optparms>(results)){
+        REQUIRE(std::abs(v-std::round(v))<.05);
     }
+    REQUIRE(std::get<swarm_utils::fnval>(results)<rastigrinScale);
+}
+
+TEST_CASE("Test quantization of extreme values", "[Cache]"){
+    REQUIRE(swarm_utils::quantizeValue(1.26, .1)==13);
+    REQUIRE(swarm_utils::quantizeValue(-1.26, .1)==-13);
+    //ratios beyond the range of long long are clamped rather than undefined
+    REQUIRE(swarm_utils::quantizeValue(1e300, 1e-12)==4611686018427387904ll);
+    REQUIRE(swarm_utils::quantizeValue(-std::numeric_limits<double>::infinity(), 1e-12)==-4611686018427387904ll);
+    REQUIRE(swarm_utils::quantizeValue(std::nan(""), 1e-12)==std::numeric_limits<long long>::min());
+    swarm_utils::EvaluationCache cache(4, 1e-12);
+    int numCalls=0;
+    auto objFn=[&](const std::vector<double>& inputs){
+        ++numCalls;
+        return inputs[0];
+    };
+    cache.evaluate(std::vector<double>({1e300}), objFn);
+    cache.evaluate(std::vector<double>({1e300}), objFn);
+    REQUIRE(numCalls==1);
+}
+TEST_CASE("Test EvaluationCache hits and eviction", "[Cache]"){
+    swarm_utils::EvaluationCache cache(2, .001);
+    int numCalls=0;
+    auto objFn=[&](const std::vector<double>& inputs){
+        ++numCalls;
+        return inputs[0]+inputs[1];
+    };
+    REQUIRE(cache.evaluate(std::vector<double>({1.0, 2.0}), objFn)==Approx(3.0));
+    REQUIRE(cache.evaluate(std::vector<double>({1.0001, 2.0}), objFn)==Approx(3.0));
+    REQUIRE(numCalls==1);
+    REQUIRE(cache.hits()==1);
+    cache.evaluate(std::vector<double>({3.0, 2.0}), objFn);
+    cache.evaluate(std::vector<double>({4.0, 2.0}), objFn);
+    REQUIRE(cache.size()==2);
+    REQUIRE(numCalls==3);
+    //{1, 2} was referenced so {3, 2} is evicted first
+    cache.evaluate(std::vector<double>({1.0, 2.0}), objFn);
+    REQUIRE(numCalls==3);
+}
+TEST_CASE("Test Rosenbrok Function with cache", "[Cuckoo]"){
+    std::vector<swarm_utils::upper_lower<double> > ul;
+    swarm_utils::upper_lower<double> bounds={-4.0, 4.0};
+    ul.push_back(bounds);
+    ul.push_back(bounds);
+    swarm_utils::EvaluationCache cache(10000, 1e-12);
+    auto objFn=swarm_utils::cacheObjective([](const std::vector<double>& inputs){
+        return futilities::const_power(1-inputs[0], 2)+100*futilities::const_power(inputs[1]-futilities::const_power(inputs[0], 2), 2);
+    }, &cache);
+    auto results=cuckoo::optimize(objFn, ul, 20, 10000, .00000001, 42);
+    std::cout<<"Cuckoo Rosenbrok cache hit rate: "<<cache.hitRate()<<", hits: "<<cache.hits()<<std::endl;
     REQUIRE(std::get<swarm_utils::fnval>(results)==Approx(0.0));
-    //REQUIRE(params[0]==Approx(1.0));
-    //REQUIRE(params[1]==Approx(1.0));
-}  
\ No newline at end of file
+    auto fireflyResults=firefly::optimize(objFn, ul, 1000, 42);
+    std::cout<<"Firefly Rosenbrok cache hit rate: "<<cache.hitRate()<<", hits: "<<cache.hits()<<std::endl;
+    REQUIRE(std::get<swarm_utils::fnval>(fireflyResults)==Approx(0.0));
+}
+
+TEST_CASE("Test EvaluationStore reuses evaluations across runs", "[EvaluationStore]"){
+    const std::string path="evaluation_store_test.bin";
+    std::remove(path.c_str());
+    std::vector<swarm_utils::upper_lower<double> > ul;
+    swarm_utils::upper_lower<double> bounds={-4.0, 4.0};
+    ul.push_back(bounds);
+    ul.push_back(bounds);
+    int numCalls=0;
+    auto rosenbrok=[&](const std::vector<double>& inputs){
+        ++numCalls;
+        return futilities::const_power(1-inputs[0], 2)+100*futilities::const_power(inputs[1]-futilities::const_power(inputs[0], 2), 2);
+    };
+    long long numStored;
+    {
+        swarm_utils::EvaluationStore store(path, 2, 7, 1e-12);
+        auto results=cuckoo::optimize(swarm_utils::storeObjective(rosenbrok, &store), ul, 20, 200, .00000001, 42);
+        numStored=store.misses();
+    }
+    const int firstCalls=numCalls;
+    {
+        //a partially written record is discarded
+        std::ofstream torn(path, std::ios::binary|std::ios::app);
+        torn<<"torn";
+    }
+    {
+        swarm_utils::EvaluationStore store(path, 2, 7, 1e-12);
+        REQUIRE(store.loaded()==numStored);
+        auto results=cuckoo::optimize(swarm_utils::storeObjective(rosenbrok, &store), ul, 20, 200, .00000001, 42);
+        REQUIRE(numCalls==firstCalls);
+        REQUIRE(store.misses()==0);
+    }
+    {
+        //other problems do not share evaluations
+        swarm_utils::EvaluationStore store(path, 2, 8, 1e-12);
+        REQUIRE(store.loaded()==0);
+        REQUIRE(store.corrupt()==0);
+    }
+    {
+        //a corrupt record in the middle is skipped, the records after it kept
+        std::fstream file(path, std::ios::binary|std::ios::in|std::ios::out);
+        const int headerSize=16;
+        const int recordSize=8*(2+3);
+        file.seekp(headerSize+recordSize+8);
+        file.put('x');
+    }
+    {
+        swarm_utils::EvaluationStore store(path, 2, 7, 1e-12);
+        REQUIRE(store.corrupt()==1);
+        REQUIRE(store.loaded()==numStored-1);
+    }
+    {
+        //a record another process is still appending blocks the open
+        //instead of being truncated as torn
+        const int recordSize=8*(2+3);
+        std::vector<char> last(recordSize);
+        {
+            std::ifstream file(path, std::ios::binary);
+            file.seekg(-recordSize, std::ios::end);
+            file.read(last.data(), recordSize);
+        }
+        const int fd=open(path.c_str(), O_WRONLY|O_APPEND);
+        REQUIRE(flock(fd, LOCK_SH)==0);
+        REQUIRE(write(fd, last.data(), recordSize/2)==recordSize/2);
+        std::atomic<bool> opened(false);
+        long long numLoaded=0;
+        std::thread reader([&](){
+            swarm_utils::EvaluationStore store(path, 2, 7, 1e-12);
+            numLoaded=store.loaded();
+            opened=true;
+        });
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        CHECK_FALSE(opened.load());
+        CHECK(write(fd, last.data()+recordSize/2, recordSize/2)==recordSize/2);
+        flock(fd, LOCK_UN);
+        close(fd);
+        reader.join();
+        REQUIRE(numLoaded==numStored);
+    }
+    std::remove(path.c_str());
+}
+
+TEST_CASE("Test warm start u^2", "[Cuckoo]"){
+    std::vector<swarm_utils::upper_lower<double> > ul;
+    swarm_utils::upper_lower<double> bounds={-5.0, 5.0};
+    for(int i=0; i<15; ++i){
+        ul.push_back(bounds);
+    }
+    int numEvaluations=0;
+    double shift=1.0;
+    auto objFn=[&](const std::vector<double>& inputs){
+        ++numEvaluations;
+        return futilities::sum(inputs, [&](const auto& v, const auto& index){
+            return futilities::const_power(v-shift, 2);
+        });
+    };
+    auto yesterday=cuckoo::optimizeFromSeeds(objFn, ul, std::vector<std::vector<double> >({std::vector<double>(15, 0.0)}), .5, 25, 25000, .00000001, 42);
+    REQUIRE(yesterday.size()==25);
+    REQUIRE(yesterday[0].second==Approx(0.0));
+    REQUIRE(std::is_sorted(yesterday.begin(), yesterday.end(), [](const auto& a, const auto& b){return a.second<b.second;}));
+    //the optimum moves a little overnight
+    shift=1.01;
+    numEvaluations=0;
+    auto cold=cuckoo::optimize(objFn, ul, 25, 25000, .00000001, 42);
+    const int coldEvaluations=numEvaluations;
+    std::vector<std::vector<double> > seeds={yesterday[0].first};
+    numEvaluations=0;
+    auto warm=cuckoo::optimizeFromSeeds(objFn, ul, seeds, .01, 25, 25000, .00000001, 42);
+    const int warmEvaluations=numEvaluations;
+    std::cout<<"Cuckoo u^2 evaluations to target, cold: "<<coldEvaluations<<", warm: "<<warmEvaluations<<std::endl;
+    REQUIRE(std::get<swarm_utils::fnval>(cold)==Approx(0.0));
+    REQUIRE(warm[0].second==Approx(0.0));
+}
+
+TEST_CASE("Test firefly warm start", "[FireFly]"){
+    std::vector<swarm_utils::upper_lower<double> > ul(3, swarm_utils::upper_lower<double>(-4.0, 4.0));
+    int numEvaluations=0;
+    auto objFn=[&](const std::vector<double>& inputs){
+        ++numEvaluations;
+        return futilities::sum(inputs, [](const auto& v, const auto& index){
+            return futilities::const_power(v-1.0, 2);
+        });
+    };
+    const std::vector<std::vector<double> > seeds={std::vector<double>(3, 1.0), std::vector<double>(3, -2.0)};
+    SECTION("From seeds"){
+        const auto population=firefly::optimizeFromSeeds(objFn, ul, seeds, .01, 10, 0, 42);
+        //no generations: the population is the seeds and points around them
+        REQUIRE(population.size()==10);
+        REQUIRE(numEvaluations==10);
+        REQUIRE(population[0].second==0.0);
+        REQUIRE(population[0].first==seeds[0]);
+        REQUIRE(std::is_sorted(population.begin(), population.end(), [](const auto& a, const auto& b){return a.second<b.second;}));
+        const auto warm=firefly::optimizeFromSeeds(objFn, ul, seeds, .01, 10, 50, 42);
+        REQUIRE(warm[0].second==0.0);
+    }
+    SECTION("From a population"){
+        const swarm_utils::Population previous={{seeds[0], 0.0}, {seeds[1], 27.0}};
+        const auto population=firefly::optimizePopulation(objFn, ul, previous, 0, 42);
+        //the values of the population are trusted and not recomputed
+        REQUIRE(numEvaluations==0);
+        REQUIRE(population==previous);
+    }
+    SECTION("Without seeds"){
+        REQUIRE_THROWS_AS(firefly::optimizeFromSeeds(objFn, ul, std::vector<std::vector<double> >(), .01, 10, 50, 42), const std::invalid_argument&);
+        REQUIRE_THROWS_AS(cuckoo::optimizeFromSeeds(objFn, ul, std::vector<std::vector<double> >(), .01, 10, 50, 0.0, 42), const std::invalid_argument&);
+    }
+}
+
+TEST_CASE("Test checkpoint resume is identical", "[Checkpoint]"){
+    const std::string path="checkpoint_test.bin";
+    std::remove(path.c_str());
+    std::vector<swarm_utils::upper_lower<double> > ul;
+    swarm_utils::upper_lower<double> bounds={-4.0, 4.0};
+    ul.push_back(bounds);
+    ul.push_back(bounds);
+    int numEvaluations=0;
+    int crashAt=-1;
+    auto rosenbrok=[&](const std::vector<double>& inputs){
+        if(++numEvaluations==crashAt){
+            throw std::runtime_error("preempted");
+        }
+        return futilities::const_power(1-inputs[0], 2)+100*futilities::const_power(inputs[1]-futilities::const_power(inputs[0], 2), 2);
+    };
+    SECTION("Cuckoo"){
+        auto expected=cuckoo::optimize(rosenbrok, ul, 20, 500, 0.0, 42);
+        numEvaluations=0;
+        crashAt=3000;
+        REQUIRE_THROWS(cuckoo::optimize(rosenbrok, ul, 20, 500, 0.0, 42, path, 25));
+        crashAt=-1;
+        auto resumed=cuckoo::resume(rosenbrok, ul, 0.0, path, 25);
+        REQUIRE(resumed.second==expected.second);
+        REQUIRE(resumed.first==expected.first);
+    }
+    SECTION("Firefly"){
+        auto expected=firefly::optimize(rosenbrok, ul, 200, 42);
+        numEvaluations=0;
+        crashAt=20000;
+        REQUIRE_THROWS(firefly::optimize(rosenbrok, ul, 200, 42, path, 10));
+        crashAt=-1;
+        auto resumed=firefly::resume(rosenbrok, ul, path, 10);
+        REQUIRE(resumed.second==expected.second);
+        REQUIRE(resumed.first==expected.first);
+    }
+    SECTION("Invalid period"){
+        REQUIRE_THROWS_AS(cuckoo::optimize(rosenbrok, ul, 20, 500, 0.0, 42, path, 0), const std::invalid_argument&);
+        REQUIRE_THROWS_AS(firefly::optimize(rosenbrok, ul, 200, 42, path, -1), const std::invalid_argument&);
+    }
+    SECTION("Corrupt checkpoint"){
+        swarm_utils::Checkpoint checkpoint;
+        checkpoint.population.push_back(std::make_pair(std::vector<double>({1.0, 1.0}), 0.0));
+        checkpoint.totalMC=10;
+        checkpoint.rngState=swarm_utils::RandomGenerator(42).getState();
+        REQUIRE(swarm_utils::writeCheckpoint(path, checkpoint));
+        swarm_utils::Checkpoint read;
+        REQUIRE(swarm_utils::readCheckpoint(path, &read));
+        //sizes in the header larger than the file
+        FILE* file=fopen(path.c_str(), "r+b");
+        const uint32_t hugeSize=0xffffffff;
+        fseek(file, 32, SEEK_SET);
+        fwrite(&hugeSize, sizeof(uint32_t), 1, file);
+        fclose(file);
+        REQUIRE_FALSE(swarm_utils::readCheckpoint(path, &read));
+        //empty population
+        checkpoint.population.clear();
+        REQUIRE(swarm_utils::writeCheckpoint(path, checkpoint));
+        REQUIRE_FALSE(swarm_utils::readCheckpoint(path, &read));
+        REQUIRE_THROWS_AS(cuckoo::makeOptimizerFromCheckpoint(rosenbrok, ul, checkpoint, 0.0), const std::invalid_argument&);
+        //wrong number of parameters
+        checkpoint.population.push_back(std::make_pair(std::vector<double>({1.0, 1.0, 1.0}), 0.0));
+        REQUIRE_THROWS_AS(cuckoo::makeOptimizerFromCheckpoint(rosenbrok, ul, checkpoint, 0.0), const std::invalid_argument&);
+        REQUIRE_THROWS_AS(firefly::makeOptimizerFromCheckpoint(rosenbrok, ul, checkpoint), const std::invalid_argument&);
+        //random generator state that getState did not produce
+        checkpoint.population[0].first.pop_back();
+        checkpoint.rngState="not a state";
+        REQUIRE_THROWS_AS(cuckoo::makeOptimizerFromCheckpoint(rosenbrok, ul, checkpoint, 0.0), const std::invalid_argument&);
+        REQUIRE(swarm_utils::writeCheckpoint(path, checkpoint));
+        REQUIRE_THROWS_AS(firefly::resume(rosenbrok, ul, path, 10), const std::invalid_argument&);
+    }
+    std::remove(path.c_str());
+}
+
+TEST_CASE("Test step-wise optimizers can be interleaved", "[Optimizer]"){
+    std::vector<swarm_utils::upper_lower<double> > ul;
+    swarm_utils::upper_lower<double> bounds={-4.0, 4.0};
+    ul.push_back(bounds);
+    ul.push_back(bounds);
+    auto rosenbrok=[](const std::vector<double>& inputs){
+        return futilities::const_power(1-inputs[0], 2)+100*futilities::const_power(inputs[1]-futilities::const_power(inputs[0], 2), 2);
+    };
+    auto cuckooOptimizer=cuckoo::makeOptimizer(rosenbrok, ul, 20, 10000, .00000001, 42);
+    auto fireflyOptimizer=firefly::makeOptimizer(rosenbrok, ul, 1000, 42);
+    double previousBest=cuckooOptimizer.best().second;
+    while(!cuckooOptimizer.done()||!fireflyOptimizer.done()){
+        cuckooOptimizer.step();
+        fireflyOptimizer.step();
+        REQUIRE(cuckooOptimizer.best().second<=previousBest);
+        previousBest=cuckooOptimizer.best().second;
+    }
+    REQUIRE(cuckooOptimizer.step()==false);
+    REQUIRE(fireflyOptimizer.iteration()==1000);
+    REQUIRE(cuckooOptimizer.population().size()==20);
+    REQUIRE(fireflyOptimizer.population().size()==firefly::n);
+    //the thin wrappers give the same answer
+    REQUIRE(cuckooOptimizer.best().second==cuckoo::optimize(rosenbrok, ul, 20, 10000, .00000001, 42).second);
+    REQUIRE(fireflyOptimizer.best().second==firefly::optimize(rosenbrok, ul, 1000, 42).second);
+}
+
+TEST_CASE("Test evaluation and deadline budgets", "[Budget]"){
+    std::vector<swarm_utils::upper_lower<double> > ul;
+    swarm_utils::upper_lower<double> bounds={-4.0, 4.0};
+    ul.push_back(bounds);
+    ul.push_back(bounds);
+    int numEvaluations=0;
+    auto rosenbrok=[&](const std::vector<double>& inputs){
+        ++numEvaluations;
+        return futilities::const_power(1-inputs[0], 2)+100*futilities::const_power(inputs[1]-futilities::const_power(inputs[0], 2), 2);
+    };
+    SECTION("Cuckoo evaluation budget"){
+        auto optimizer=cuckoo::makeOptimizer(rosenbrok, ul, 20, 10000, 0.0, 42, swarm_utils::EvaluationBudget().withMaxEvaluations(1000));
+        while(optimizer.step()){}
+        REQUIRE(numEvaluations==1000);
+        REQUIRE(optimizer.evaluations()==1000);
+        REQUIRE(optimizer.best().second<=optimizer.population()[0].second);
+        REQUIRE(optimizer.best().second<1.0);
+        //nests are not abandoned for points that were never evaluated
+        for(const auto& member:optimizer.population()){
+            REQUIRE(std::isfinite(member.second));
+        }
+    }
+    SECTION("Firefly evaluation budget"){
+        auto results=firefly::optimize(rosenbrok, ul, 1000, 42, swarm_utils::EvaluationBudget().withMaxEvaluations(777));
+        REQUIRE(numEvaluations==777);
+        REQUIRE(std::get<swarm_utils::fnval>(results)==rosenbrok(std::get<swarm_utils::optparms>(results)));
+        numEvaluations=0;
+        auto optimizer=firefly::makeOptimizer(rosenbrok, ul, 1000, 42, firefly::AllPairsUpdate(), swarm_utils::EvaluationBudget().withMaxEvaluations(777));
+        while(optimizer.step()){}
+        //fireflies do not move to points that were never evaluated
+        for(const auto& member:optimizer.population()){
+            REQUIRE(std::isfinite(member.second));
+            REQUIRE(member.second==rosenbrok(member.first));
+        }
+    }
+    SECTION("Deadline"){
+        //wall clock time depends on the load of the machine, so check that no
+        //evaluation starts after the deadline rather than the elapsed time
+        swarm_utils::EvaluationBudget::Clock::time_point lastStart;
+        auto slow=[&](const std::vector<double>& inputs){
+            lastStart=swarm_utils::EvaluationBudget::Clock::now();
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            return rosenbrok(inputs);
+        };
+        auto start=swarm_utils::EvaluationBudget::Clock::now();
+        const auto deadline=start+std::chrono::milliseconds(200);
+        auto optimizer=cuckoo::makeOptimizer(slow, ul, 20, 10000, 0.0, 42, swarm_utils::EvaluationBudget().withDeadline(deadline));
+        while(optimizer.step()){}
+        std::chrono::duration<double, std::milli> elapsed=swarm_utils::EvaluationBudget::Clock::now()-start;
+        std::cout<<"Cuckoo with 200 ms deadline: "<<elapsed.count()<<" ms, "<<numEvaluations<<" evaluations, obj fn: "<<optimizer.best().second<<std::endl;
+        REQUIRE(optimizer.done());
+        REQUIRE(optimizer.iteration()<10000);
+        REQUIRE(numEvaluations==optimizer.evaluations());
+        REQUIRE(lastStart<deadline);
+        REQUIRE(optimizer.best().second<std::numeric_limits<double>::infinity());
+    }
+}
+
+TEST_CASE("Test convergence detectors stop early", "[Convergence]"){
+    std::vector<swarm_utils::upper_lower<double> > ul;
+    swarm_utils::upper_lower<double> bounds={-4.0, 4.0};
+    ul.push_back(bounds);
+    ul.push_back(bounds);
+    ul.push_back(bounds);
+    auto sphere=[](const std::vector<double>& inputs){
+        return inputs[0]*inputs[0]+inputs[1]*inputs[1]+inputs[2]*inputs[2];
+    };
+    SECTION("Cuckoo stagnation"){
+        auto rastigrin=[](const std::vector<double>& inputs){
+            return rastigrinScale*inputs.size()+futilities::sum(inputs, [](const auto& val, const auto& index){
+                return futilities::const_power(val, 2)-rastigrinScale*cos(2*M_PI*val);
+            });
+        };
+        auto optimizer=cuckoo::makeOptimizer(rastigrin, ul, 25, 10000, -1.0, 42);
+        optimizer.setConvergence(swarm_utils::ConvergenceCriteria().withStagnation(200, 1e-6));
+        while(optimizer.step()){}
+        std::cout<<"Cuckoo stagnation after "<<optimizer.iteration()<<" iterations, obj fn: "<<optimizer.best().second<<std::endl;
+        REQUIRE(optimizer.convergence()==swarm_utils::Convergence::stagnation);
+        REQUIRE(optimizer.iteration()<10000);
+    }
+    SECTION("Cuckoo fitness spread"){
+        auto optimizer=cuckoo::makeOptimizer(sphere, ul, 25, 10000, 0.0, 42);
+        optimizer.setConvergence(swarm_utils::ConvergenceCriteria().withMinFitnessSpread(1e-10));
+        while(optimizer.step()){}
+        REQUIRE(optimizer.convergence()==swarm_utils::Convergence::fitnessSpread);
+        REQUIRE(optimizer.iteration()<10000);
+        REQUIRE(optimizer.best().second==Approx(0.0));
+    }
+    SECTION("Firefly diameter"){
+        auto optimizer=firefly::makeOptimizer(sphere, ul, 1000, 42);
+        optimizer.setConvergence(swarm_utils::ConvergenceCriteria().withMinDiameter(1e-6));
+        while(optimizer.step()){}
+        std::cout<<"Firefly diameter collapse after "<<optimizer.iteration()<<" iterations, obj fn: "<<optimizer.best().second<<std::endl;
+        REQUIRE(optimizer.convergence()==swarm_utils::Convergence::diameter);
+        REQUIRE(optimizer.iteration()<1000);
+        REQUIRE(optimizer.best().second==Approx(0.0));
+    }
+}
+
+TEST_CASE("Test restarts on Rastigrin", "[Restart]"){
+    std::vector<swarm_utils::upper_lower<double> > ul;
+    swarm_utils::upper_lower<double> bounds={-4.0, 4.0};
+    ul.push_back(bounds);
+    ul.push_back(bounds);
+    ul.push_back(bounds);
+    ul.push_back(bounds);
+    auto rastigrin=[](const std::vector<double>& inputs){
+        return rastigrinScale*inputs.size()+futilities::sum(inputs, [](const auto& val, const auto& index){
+            return futilities::const_power(val, 2)-rastigrinScale*cos(2*M_PI*val);
+        });
+    };
+    const long long totalEvaluations=200000;
+    SECTION("Cuckoo"){
+        auto single=cuckoo::optimize(rastigrin, ul, 25, 10000, .00000001, 7, swarm_utils::EvaluationBudget().withMaxEvaluations(totalEvaluations));
+        auto results=cuckoo::optimizeWithRestarts(rastigrin, ul, 10, totalEvaluations, .00000001, 7, swarm_utils::RestartStrategy().withThreads(2));
+        std::cout<<"Cuckoo Rastigrin single run: "<<single.second<<", with restarts: "<<results.second<<" after "<<results.numRuns<<" runs and "<<results.numEvaluations<<" evaluations"<<std::endl;
+        REQUIRE(results.numEvaluations<=totalEvaluations);
+        REQUIRE(std::get<swarm_utils::fnval>(results)==Approx(0.0));
+    }
+    SECTION("Firefly"){
+        //the first run with this seed is caught in a local minimum
+        auto results=firefly::optimizeWithRestarts(rastigrin, ul, 25, 500000, .00000001, 3, swarm_utils::RestartStrategy().withCriteria(swarm_utils::ConvergenceCriteria().withStagnation(50, 1e-6)));
+        std::cout<<"Firefly Rastigrin with restarts: "<<results.second<<" after "<<results.numRuns<<" runs and "<<results.numEvaluations<<" evaluations"<<std::endl;
+        REQUIRE(results.numRuns>1);
+        REQUIRE(results.numEvaluations<=500000);
+        REQUIRE(std::get<swarm_utils::fnval>(results)==Approx(0.0));
+    }
+    SECTION("Population cap"){
+        std::vector<int> sizes;
+        auto results=swarm_utils::runRestarts([&](int numNests, int runSeed, const swarm_utils::EvaluationBudget& budget){
+            sizes.push_back(numNests);
+            return cuckoo::makeOptimizer(rastigrin, ul, numNests, 5, 0.0, runSeed, budget);
+        }, 10, 20000, 0.0, 7, swarm_utils::RestartStrategy().withPopulationGrowth(10.0).withMaxPopulation(400).withThreads(1));
+        REQUIRE(results.numRuns>3);
+        REQUIRE(sizes[0]==10);
+        REQUIRE(sizes[1]==100);
+        for(int run=2; run<sizes.size(); ++run){
+            REQUIRE(sizes[run]==400);
+        }
+    }
+    SECTION("Throwing objective"){
+        std::atomic<int> numEvaluations(0);
+        auto failing=[&](const std::vector<double>& inputs){
+            if(++numEvaluations==1000){
+                throw std::runtime_error("objective failed");
+            }
+            return rastigrin(inputs);
+        };
+        REQUIRE_THROWS_AS(cuckoo::optimizeWithRestarts(failing, ul, 10, totalEvaluations, 0.0, 7, swarm_utils::RestartStrategy().withThreads(4)), const std::runtime_error&);
+        numEvaluations=0;
+        REQUIRE_THROWS_AS(firefly::optimizeWithRestarts(failing, ul, 25, totalEvaluations, 0.0, 7), const std::runtime_error&);
+    }
+}
+
+TEST_CASE("Test cancellation and progress from another thread", "[Progress]"){
+    std::vector<swarm_utils::upper_lower<double> > ul;
+    swarm_utils::upper_lower<double> bounds={-4.0, 4.0};
+    ul.push_back(bounds);
+    ul.push_back(bounds);
+    auto rosenbrok=[](const std::vector<double>& inputs){
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+        return futilities::const_power(1-inputs[0], 2)+100*futilities::const_power(inputs[1]-futilities::const_power(inputs[0], 2), 2);
+    };
+    swarm_utils::CancellationToken token;
+    swarm_utils::Progress progress(ul.size());
+    std::pair<std::vector<double>, double> results;
+    std::thread run([&](){
+        results=cuckoo::optimize(rosenbrok, ul, 20, 1000000, 0.0, 42, swarm_utils::EvaluationBudget().withCancellation(&token), &progress);
+    });
+    swarm_utils::ProgressSnapshot snapshot;
+    while(snapshot.iteration<10){
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        progress.read(&snapshot);
+    }
+    std::cout<<snapshot<<std::endl;
+    token.cancel();
+    run.join();
+    progress.read(&snapshot);
+    REQUIRE(snapshot.iteration<1000000);
+    REQUIRE(snapshot.bestValue==results.second);
+    REQUIRE(snapshot.bestParameters==results.first);
+}
+
+struct CountingObserver: public swarm_utils::NullObserver{
+    int numGenerations=0;
+    int numEvaluations=0;
+    int numReplacements=0;
+    int numAbandonments=0;
+    template<typename Population>
+    void onGenerationEnd(int iteration, const Population& population){
+        ++numGenerations;
+    }
+    template<typename Params>
+    void onEvaluation(const Params& params, double value){
+        ++numEvaluations;
+    }
+    void onReplacement(int index, double previousValue, double newValue){
+        ++numReplacements;
+    }
+    void onAbandonment(int index){
+        ++numAbandonments;
+    }
+};
+TEST_CASE("Test observer hooks", "[Observer]"){
+    std::vector<swarm_utils::upper_lower<double> > ul;
+    swarm_utils::upper_lower<double> bounds={-4.0, 4.0};
+    ul.push_back(bounds);
+    ul.push_back(bounds);
+    auto rosenbrok=[](const std::vector<double>& inputs){
+        return futilities::const_power(1-inputs[0], 2)+100*futilities::const_power(inputs[1]-futilities::const_power(inputs[0], 2), 2);
+    };
+    SECTION("Cuckoo"){
+        CountingObserver observer;
+        auto results=cuckoo::optimize(rosenbrok, ul, 20, 100, 0.0, 42, &observer);
+        REQUIRE(results==cuckoo::optimize(rosenbrok, ul, 20, 100, 0.0, 42));
+        REQUIRE(observer.numGenerations==100);
+        REQUIRE(observer.numReplacements>0);
+        //every generation has n cuckoos, plus the abandoned nests, plus the initial nest
+        REQUIRE(observer.numEvaluations==20+100*20+observer.numAbandonments);
+    }
+    SECTION("Firefly"){
+        CountingObserver observer;
+        auto results=firefly::optimize(rosenbrok, ul, 100, 42, &observer);
+        REQUIRE(results==firefly::optimize(rosenbrok, ul, 100, 42));
+        REQUIRE(observer.numGenerations==100);
+        REQUIRE(observer.numEvaluations==firefly::n+observer.numReplacements);
+        REQUIRE(observer.numAbandonments==0);
+    }
+}
+//the default observer holds no state, so every hook is an empty inline call
+static_assert(std::is_empty<swarm_utils::NullObserver>::value, "NullObserver must be stateless");
+TEST_CASE("Benchmark NullObserver overhead", "[Observer][.]"){
+    std::vector<swarm_utils::upper_lower<double> > ul;
+    swarm_utils::upper_lower<double> bounds={-4.0, 4.0};
+    ul.push_back(bounds);
+    ul.push_back(bounds);
+    auto sphere=[](const std::vector<double>& inputs){
+        return inputs[0]*inputs[0]+inputs[1]*inputs[1];
+    };
+    const int numReps=11;
+    double plainTime=std::numeric_limits<double>::infinity();
+    double observedTime=std::numeric_limits<double>::infinity();
+    swarm_utils::NullObserver observer;
+    for(int rep=0; rep<numReps; ++rep){
+        auto start=std::chrono::steady_clock::now();
+        auto plain=cuckoo::optimize(sphere, ul, 25, 2000, -1.0, 42);
+        std::chrono::duration<double, std::milli> plainElapsed=std::chrono::steady_clock::now()-start;
+        start=std::chrono::steady_clock::now();
+        auto observed=cuckoo::optimize(sphere, ul, 25, 2000, -1.0, 42, &observer);
+        std::chrono::duration<double, std::milli> observedElapsed=std::chrono::steady_clock::now()-start;
+        plainTime=std::min(plainTime, plainElapsed.count());
+        observedTime=std::min(observedTime, observedElapsed.count());
+        REQUIRE(plain==observed);
+    }
+    std::cout<<"Cuckoo 2000 iterations, best of "<<numReps<<": without observer "<<plainTime<<" ms, with NullObserver "<<observedTime<<" ms"<<std::endl;
+    REQUIRE(observedTime<plainTime*1.2);
+}
+TEST_CASE("Test run statistics", "[Statistics]"){
+    std::vector<swarm_utils::upper_lower<double> > ul;
+    swarm_utils::upper_lower<double> bounds={-4.0, 4.0};
+    ul.push_back(bounds);
+    ul.push_back(bounds);
+    auto rosenbrok=[](const std::vector<double>& inputs){
+        return futilities::const_power(1-inputs[0], 2)+100*futilities::const_power(inputs[1]-futilities::const_power(inputs[0], 2), 2);
+    };
+    SECTION("Cuckoo"){
+        CountingObserver observer;
+        auto results=cuckoo::optimize(rosenbrok, ul, 20, 100, 0.0, 42, &observer);
+        REQUIRE(results.statistics.iterations==100);
+        REQUIRE(results.statistics.evaluations==observer.numEvaluations);
+        REQUIRE(results.statistics.improvingReplacements>0);
+        REQUIRE(results.statistics.improvingReplacements<=observer.numReplacements);
+        REQUIRE(results.statistics.evaluationTicks>0);
+        REQUIRE(results.statistics.generationTicks>0);
+        REQUIRE(results.statistics.sortTicks>0);
+        REQUIRE(results.statistics.abandonmentTicks>0);
+        REQUIRE(std::get<1>(results)==cuckoo::optimize(rosenbrok, ul, 20, 100, 0.0, 42).second);
+    }
+    SECTION("Firefly"){
+        auto results=firefly::optimize(rosenbrok, ul, 100, 42);
+        REQUIRE(results.statistics.iterations==100);
+        REQUIRE(results.statistics.evaluations>firefly::n);
+        REQUIRE(results.statistics.improvingReplacements>0);
+        REQUIRE(results.statistics.abandonmentTicks==0);
+        REQUIRE(swarm_utils::RunStatistics::seconds(results.statistics.evaluationTicks)>0.0);
+        REQUIRE(results.statistics.evaluationFraction()>0.0);
+        REQUIRE(results.statistics.evaluationFraction()<1.0);
+    }
+}
+TEST_CASE("Test trace recorder", "[Trace]"){
+    std::vector<swarm_utils::upper_lower<double> > ul;
+    swarm_utils::upper_lower<double> bounds={-4.0, 4.0};
+    ul.push_back(bounds);
+    ul.push_back(bounds);
+    auto rosenbrok=[](const std::vector<double>& inputs){
+        return futilities::const_power(1-inputs[0], 2)+100*futilities::const_power(inputs[1]-futilities::const_power(inputs[0], 2), 2);
+    };
+    const std::string path="trace_test.bin";
+    SECTION("Trace matches the run"){
+        //small chunks so that the optimizer wraps around the ring
+        swarm_utils::TraceRecorder recorder(path, 2, true, 4096, 2);
+        auto results=cuckoo::optimize(rosenbrok, ul, 20, 100, 0.0, 42, &recorder);
+        REQUIRE(recorder.close());
+        std::stringstream generations;
+        std::stringstream evaluations;
+        REQUIRE(swarm_utils::traceToCsv(path, generations, evaluations));
+        std::string line;
+        int numGenerations=0;
+        double previousBest=std::numeric_limits<double>::infinity();
+        double best=0.0;
+        while(std::getline(generations, line)){
+            std::stringstream row(line);
+            std::string cell;
+            std::getline(row, cell, ',');
+            REQUIRE(std::stoi(cell)==numGenerations);
+            std::getline(row, cell, ',');
+            best=std::stod(cell);
+            REQUIRE(best<=previousBest);
+            previousBest=best;
+            int numMembers=0;
+            while(std::getline(row, cell, ',')){
+                ++numMembers;
+            }
+            REQUIRE(numMembers==20);
+            ++numGenerations;
+        }
+        REQUIRE(numGenerations==100);
+        REQUIRE(best==std::get<1>(results));
+        int numEvaluations=0;
+        while(std::getline(evaluations, line)){
+            ++numEvaluations;
+        }
+        REQUIRE(numEvaluations==results.statistics.evaluations);
+    }
+    SECTION("Not a trace"){
+        std::ofstream(path)<<"not a trace";
+        std::stringstream generations;
+        std::stringstream evaluations;
+        REQUIRE(!swarm_utils::traceToCsv(path, generations, evaluations));
+        REQUIRE(!swarm_utils::traceToCsv("missing_trace.bin", generations, evaluations));
+    }
+    SECTION("Record past the end of its chunk"){
+        auto writeTrace=[&](const std::vector<unsigned char>& chunk){
+            std::ofstream file(path, std::ios::binary);
+            const uint32_t numParams=2;
+            const uint32_t chunkHeader[2]={(uint32_t)chunk.size(), 1};
+            file.write(swarm_utils::trace::getMagic(), 8);
+            file.write((const char*)&numParams, sizeof(uint32_t));
+            file.write((const char*)chunkHeader, sizeof(chunkHeader));
+            file.write((const char*)chunk.data(), chunk.size());
+        };
+        std::stringstream generations;
+        std::stringstream evaluations;
+        //a generation of 1000 members holding a single value
+        std::vector<unsigned char> chunk(1+sizeof(int64_t)+sizeof(uint32_t)+sizeof(double), 0);
+        chunk[0]=swarm_utils::trace::generationTag;
+        const uint32_t populationSize=1000;
+        std::memcpy(chunk.data()+1+sizeof(int64_t), &populationSize, sizeof(uint32_t));
+        writeTrace(chunk);
+        REQUIRE(!swarm_utils::traceToCsv(path, generations, evaluations));
+        //a header cut short
+        writeTrace(std::vector<unsigned char>(chunk.begin(), chunk.begin()+5));
+        REQUIRE(!swarm_utils::traceToCsv(path, generations, evaluations));
+        //an evaluation missing its value
+        chunk.assign(1+sizeof(double)*2, 0);
+        chunk[0]=swarm_utils::trace::evaluationTag;
+        writeTrace(chunk);
+        REQUIRE(!swarm_utils::traceToCsv(path, generations, evaluations));
+        REQUIRE(generations.str().empty());
+        REQUIRE(evaluations.str().empty());
+    }
+    std::remove(path.c_str());
+}
+TEST_CASE("Benchmark trace recorder", "[Trace][.]"){
+    std::vector<swarm_utils::upper_lower<double> > ul;
+    swarm_utils::upper_lower<double> bounds={-4.0, 4.0};
+    for(int i=0; i<10; ++i){
+        ul.push_back(bounds);
+    }
+    auto sphere=[](const std::vector<double>& inputs){
+        return futilities::sum(inputs, [](const auto& v, const auto& index){
+            return v*v;
+        });
+    };
+    const std::string path="trace_benchmark.bin";
+    const int numReps=3;
+    double plainTime=std::numeric_limits<double>::infinity();
+    double tracedTime=std::numeric_limits<double>::infinity();
+    long long numEvaluations=0;
+    for(int rep=0; rep<numReps; ++rep){
+        auto start=std::chrono::steady_clock::now();
+        auto plain=cuckoo::optimize(sphere, ul, 25, 20000, -1.0, 42);
+        std::chrono::duration<double, std::milli> plainElapsed=std::chrono::steady_clock::now()-start;
+        start=std::chrono::steady_clock::now();
+        swarm_utils::TraceRecorder recorder(path, 10, true);
+        auto traced=cuckoo::optimize(sphere, ul, 25, 20000, -1.0, 42, &recorder);
+        REQUIRE(recorder.close());
+        std::chrono::duration<double, std::milli> tracedElapsed=std::chrono::steady_clock::now()-start;
+        plainTime=std::min(plainTime, plainElapsed.count());
+        tracedTime=std::min(tracedTime, tracedElapsed.count());
+        numEvaluations=traced.statistics.evaluations;
+        REQUIRE(std::get<1>(plain)==std::get<1>(traced));
+    }
+    std::remove(path.c_str());
+    std::cout<<"Cuckoo "<<numEvaluations<<" evaluations, best of "<<numReps<<": untraced "<<plainTime<<" ms, traced "<<tracedTime<<" ms"<<std::endl;
+}
+TEST_CASE("Test benchmark problems", "[Problems]"){
+    for(int dimension:{2, 10}){
+        const auto problems=swarm_utils::getProblems(dimension, 2018);
+        REQUIRE(problems.size()==9);
+        for(const auto& problem:problems){
+            REQUIRE(problem.bounds.size()==dimension);
+            REQUIRE(problem.objective(problem.optimum)==Approx(0.0));
+            //any other point in the box is worse
+            std::vector<double> corner(dimension);
+            for(int i=0; i<dimension; ++i){
+                corner[i]=problem.bounds[i].lower;
+            }
+            REQUIRE(problem.objective(corner)>1e-3);
+            //and points outside are worse still
+            corner[0]-=1.0;
+            REQUIRE(problem.objective(corner)>1e-3);
+        }
+    }
+    //the same seed gives the same shifts
+    REQUIRE(swarm_utils::getProblems(5, 1)[0].optimum==swarm_utils::getProblems(5, 1)[0].optimum);
+}
+TEST_CASE("Test Mantegna Levy steps", "[Levy]"){
+    //tabulated value for lambda=1.5
+    REQUIRE(swarm_utils::getMantegnaSigma(1.5)==Approx(0.696575));
+    swarm_utils::RandomGenerator rng(42);
+    auto unifL=[&](){return rng.getUniform();};
+    auto normL=[&](){return rng.getNorm();};
+    swarm_utils::MantegnaLevy mantegna(1.5);
+    swarm_utils::PowerLawLevy powerLaw(1.5);
+    //both tails fall as x^-lambda, so ten times further out there are
+    //10^-1.5 times as many steps; Mantegna's steps have the smaller scale,
+    //so fewer of them pass either threshold
+    const int numDraws=1000000;
+    int numLargeMantegna[2]={0, 0};
+    int numLargePowerLaw[2]={0, 0};
+    for(int i=0; i<numDraws; ++i){
+        const double mantegnaStep=std::abs(mantegna(0.0, 1.0, unifL, normL));
+        const double powerLawStep=std::abs(powerLaw(0.0, 1.0, unifL, normL));
+        numLargeMantegna[0]+=mantegnaStep>10;
+        numLargeMantegna[1]+=mantegnaStep>100;
+        numLargePowerLaw[0]+=powerLawStep>10;
+        numLargePowerLaw[1]+=powerLawStep>100;
+    }
+    const double expectedDecay=std::pow(10.0, -1.5);
+    REQUIRE((double)numLargeMantegna[1]/numLargeMantegna[0]==Approx(expectedDecay).epsilon(.2));
+    REQUIRE((double)numLargePowerLaw[1]/numLargePowerLaw[0]==Approx(expectedDecay).epsilon(.2));
+    REQUIRE(numLargeMantegna[0]<numLargePowerLaw[0]);
+    REQUIRE(numLargeMantegna[1]<numLargePowerLaw[1]);
+    //and the search still converges with them
+    std::vector<swarm_utils::upper_lower<double> > ul(2, swarm_utils::upper_lower<double>(-4.0, 4.0));
+    auto sphere=[](const std::vector<double>& inputs){
+        return inputs[0]*inputs[0]+inputs[1]*inputs[1];
+    };
+    const long long maxEvaluations=100000;
+    REQUIRE(getExpectedRunningTime([&](int seed){
+        return cuckoo::makeOptimizer<swarm_utils::MantegnaLevy>(
+            sphere, ul, 25, maxEvaluations/25, 1e-6, seed, swarm_utils::EvaluationBudget().withMaxEvaluations(maxEvaluations)
+        );
+    }, 3, 1e-6)<maxEvaluations);
+}
+TEST_CASE("Benchmark Levy steps", "[Levy][.]"){
+    std::vector<swarm_utils::upper_lower<double> > ul;
+    swarm_utils::upper_lower<double> bounds={-4.0, 4.0};
+    ul.push_back(bounds);
+    ul.push_back(bounds);
+    auto sphere=[](const std::vector<double>& inputs){
+        return inputs[0]*inputs[0]+inputs[1]*inputs[1];
+    };
+    auto rosenbrok=[](const std::vector<double>& inputs){
+        return futilities::const_power(1-inputs[0], 2)+100*futilities::const_power(inputs[1]-futilities::const_power(inputs[0], 2), 2);
+    };
+    auto rastrigin=[](const std::vector<double>& inputs){
+        return 20+futilities::sum(inputs, [](const auto& v, const auto& index){
+            return v*v-10*cos(2*M_PI*v);
+        });
+    };
+    const double target=1e-6;
+    const int numSeeds=10;
+    const long long maxEvaluations=100000;
+    auto compare=[&](const std::string& name, const auto& objFn){
+        const auto budget=swarm_utils::EvaluationBudget().withMaxEvaluations(maxEvaluations);
+        const double powerLaw=getExpectedRunningTime([&](int seed){
+            return cuckoo::makeOptimizer(objFn, ul, 25, maxEvaluations/25, target, seed, budget);
+        }, numSeeds, target);
+        const double mantegna=getExpectedRunningTime([&](int seed){
+            return cuckoo::makeOptimizer<swarm_utils::MantegnaLevy>(objFn, ul, 25, maxEvaluations/25, target, seed, budget);
+        }, numSeeds, target);
+        std::cout<<name<<" evaluations to "<<target<<": power law "<<powerLaw<<", Mantegna "<<mantegna<<std::endl;
+        return mantegna;
+    };
+    REQUIRE(compare("Sphere", sphere)<maxEvaluations);
+    compare("Rosenbrock", rosenbrok);
+    compare("Rastrigin", rastrigin);
+}
+TEST_CASE("Test boundary policies", "[Boundary]"){
+    swarm_utils::RandomGenerator rng(42);
+    auto normL=[&](){return rng.getNorm();};
+    const double lower=-1.0;
+    const double upper=3.0;
+    auto check=[&](const auto& policy){
+        //values inside, including the faces, are untouched, values outside end up inside
+        REQUIRE(policy(2.5, lower, upper, 0.0, normL)==2.5);
+        REQUIRE(policy(lower, lower, upper, 0.0, normL)==lower);
+        REQUIRE(policy(upper, lower, upper, 0.0, normL)==upper);
+        //a box of zero width has a single point
+        REQUIRE(policy(5.0, 1.0, 1.0, 1.0, normL)==1.0);
+        REQUIRE(policy(-5.0, 1.0, 1.0, 1.0, normL)==1.0);
+        for(double value=-20.0; value<=20.0; value+=.37){
+            const double bounded=policy(value, lower, upper, 0.0, normL);
+            REQUIRE(bounded>=lower);
+            REQUIRE(bounded<=upper);
+        }
+    };
+    check(swarm_utils::ClampBoundary());
+    check(swarm_utils::ReflectBoundary());
+    check(swarm_utils::WrapBoundary());
+    check(swarm_utils::ReinitializeBoundary());
+    check(swarm_utils::MidpointBoundary());
+    REQUIRE(swarm_utils::ClampBoundary()(3.5, lower, upper, 0.0, normL)==upper);
+    REQUIRE(swarm_utils::ReflectBoundary()(3.5, lower, upper, 0.0, normL)==2.5);
+    REQUIRE(swarm_utils::ReflectBoundary()(-1.5, lower, upper, 0.0, normL)==-.5);
+    REQUIRE(swarm_utils::WrapBoundary()(3.5, lower, upper, 0.0, normL)==Approx(-.5));
+    REQUIRE(swarm_utils::WrapBoundary()(-1.5, lower, upper, 0.0, normL)==Approx(2.5));
+    REQUIRE(swarm_utils::MidpointBoundary()(3.5, lower, upper, 2.0, normL)==2.5);
+    //every policy finds an optimum near a corner of the box, where it matters most
+    std::vector<swarm_utils::upper_lower<double> > ul(2, swarm_utils::upper_lower<double>(-4.0, 4.0));
+    auto edgeSphere=[](const std::vector<double>& inputs){
+        return futilities::const_power(inputs[0]-3.9, 2)+futilities::const_power(inputs[1]+3.9, 2);
+    };
+    const long long maxEvaluations=100000;
+    for(auto boundary:{
+        swarm_utils::Boundary::clamp, swarm_utils::Boundary::reflect, swarm_utils::Boundary::wrap, 
+        swarm_utils::Boundary::reinitialize, swarm_utils::Boundary::midpoint
+    }){
+        REQUIRE(getExpectedRunningTime([&](int seed){
+            auto optimizer=cuckoo::makeOptimizer(
+                edgeSphere, ul, 25, maxEvaluations/25, 1e-6, seed, swarm_utils::EvaluationBudget().withMaxEvaluations(maxEvaluations)
+            );
+            optimizer.setBoundary(boundary);
+            return optimizer;
+        }, 3, 1e-6)<maxEvaluations);
+    }
+}
+TEST_CASE("Benchmark boundary policies", "[Boundary][.]"){
+    std::vector<swarm_utils::upper_lower<double> > ul;
+    swarm_utils::upper_lower<double> bounds={-4.0, 4.0};
+    ul.push_back(bounds);
+    ul.push_back(bounds);
+    //optimum near a corner of the box, where the policy matters most
+    auto edgeSphere=[](const std::vector<double>& inputs){
+        return futilities::const_power(inputs[0]-3.9, 2)+futilities::const_power(inputs[1]+3.9, 2);
+    };
+    auto rosenbrok=[](const std::vector<double>& inputs){
+        return futilities::const_power(1-inputs[0], 2)+100*futilities::const_power(inputs[1]-futilities::const_power(inputs[0], 2), 2);
+    };
+    const double target=1e-6;
+    const int numSeeds=10;
+    const long long maxEvaluations=100000;
+    const std::vector<std::pair<std::string, swarm_utils::Boundary> > policies={
+        {"clamp", swarm_utils::Boundary::clamp},
+        {"reflect", swarm_utils::Boundary::reflect},
+        {"wrap", swarm_utils::Boundary::wrap},
+        {"reinitialize", swarm_utils::Boundary::reinitialize},
+        {"midpoint", swarm_utils::Boundary::midpoint}
+    };
+    auto compare=[&](const std::string& name, const auto& objFn){
+        const auto budget=swarm_utils::EvaluationBudget().withMaxEvaluations(maxEvaluations);
+        std::cout<<name<<" evaluations to "<<target<<" (cuckoo/firefly):";
+        double worstCuckoo=0;
+        for(const auto& policy:policies){
+            const double cuckooEvaluations=getExpectedRunningTime([&](int seed){
+                auto optimizer=cuckoo::makeOptimizer(objFn, ul, 25, maxEvaluations/25, target, seed, budget);
+                optimizer.setBoundary(policy.second);
+                return optimizer;
+            }, numSeeds, target);
+            const double fireflyEvaluations=getExpectedRunningTime([&](int seed){
+                auto optimizer=firefly::makeOptimizer(objFn, ul, 1000, seed, firefly::AllPairsUpdate(), budget);
+                optimizer.setBoundary(policy.second);
+                return optimizer;
+            }, numSeeds, target);
+            std::cout<<" "<<policy.first<<" "<<cuckooEvaluations<<"/"<<fireflyEvaluations;
+            worstCuckoo=std::max(worstCuckoo, cuckooEvaluations);
+        }
+        std::cout<<std::endl;
+        return worstCuckoo;
+    };
+    REQUIRE(compare("Edge sphere", edgeSphere)<maxEvaluations);
+    compare("Rosenbrock", rosenbrok);
+}
+TEST_CASE("Test differential discovery", "[Cuckoo]"){
+    std::vector<swarm_utils::upper_lower<double> > ul(3, swarm_utils::upper_lower<double>(-5.0, 5.0));
+    swarm_utils::RandomGenerator rng(42);
+    auto unifL=[&](){return rng.getUniform();};
+    auto normL=[&](){return rng.getNorm();};
+    int numEvaluations=0;
+    auto u2=[&](const std::vector<double>& inputs){
+        ++numEvaluations;
+        return futilities::sum(inputs, [](const auto& v, const auto& index){
+            return futilities::const_power(v-1.0, 2);
+        });
+    };
+    //uniform draws, so that every nest is inside the box and clamping moves none
+    auto nest=cuckoo::getNewNest(ul, u2, unifL, 10);
+    auto scratch=nest;
+    const auto start=nest;
+    int numAbandoned=0;
+    auto onAbandon=[&](int i){++numAbandoned;};
+    //every parameter is kept with probability p, so with p=1 nothing moves
+    numEvaluations=0;
+    cuckoo::discoverNests(&nest, &scratch, u2, unifL, normL, ul, 1.0, swarm_utils::ClampBoundary(), onAbandon);
+    REQUIRE(numEvaluations==0);
+    REQUIRE(numAbandoned==0);
+    REQUIRE(nest==start);
+    //nor when all the nests are at the same point
+    auto same=swarm_utils::Population(10, start[0]);
+    cuckoo::discoverNests(&same, &scratch, u2, unifL, normL, ul, 0.0, swarm_utils::ClampBoundary(), onAbandon);
+    REQUIRE(numEvaluations==0);
+    REQUIRE(numAbandoned==0);
+    //with p=0 every parameter moves unless j==k
+    cuckoo::discoverNests(&nest, &scratch, u2, unifL, normL, ul, 0.0, swarm_utils::ClampBoundary(), onAbandon);
+    REQUIRE(numEvaluations>5);
+    REQUIRE(numEvaluations<=10);
+    for(int i=0; i<10; ++i){
+        REQUIRE(nest[i].second<=start[i].second);
+        REQUIRE(nest[i].second==u2(nest[i].first));
+    }
+    //following the spread of the population pays off in higher dimension
+    std::vector<swarm_utils::upper_lower<double> > box(15, swarm_utils::upper_lower<double>(-5.0, 5.0));
+    auto evaluationsToTarget=[&](cuckoo::Discovery discovery){
+        return getExpectedRunningTime([&](int seed){
+            auto optimizer=cuckoo::makeOptimizer(u2, box, 25, 25000, 1e-8, seed);
+            optimizer.setDiscovery(discovery);
+            return optimizer;
+        }, 5, 1e-8);
+    };
+    REQUIRE(evaluationsToTarget(cuckoo::Discovery::differential)<evaluationsToTarget(cuckoo::Discovery::random));
+}
+TEST_CASE("Benchmark differential discovery", "[Cuckoo][.]"){
+    auto getBounds=[](int dimension){
+        std::vector<swarm_utils::upper_lower<double> > ul;
+        swarm_utils::upper_lower<double> bounds={-5.0, 5.0};
+        for(int i=0; i<dimension; ++i){
+            ul.push_back(bounds);
+        }
+        return ul;
+    };
+    auto u2=[](const std::vector<double>& inputs){
+        return futilities::sum(inputs, [](const auto& v, const auto& index){
+            return futilities::const_power(v-1.0, 2);
+        });
+    };
+    auto rosenbrok=[](const std::vector<double>& inputs){
+        return futilities::const_power(1-inputs[0], 2)+100*futilities::const_power(inputs[1]-futilities::const_power(inputs[0], 2), 2);
+    };
+    auto rastrigin=[](const std::vector<double>& inputs){
+        return 20+futilities::sum(inputs, [](const auto& v, const auto& index){
+            return v*v-10*cos(2*M_PI*v);
+        });
+    };
+    const double target=1e-8;
+    const int numSeeds=5;
+    auto evaluationsToTarget=[&](const auto& objFn, int dimension, int maxMC, cuckoo::Discovery discovery){
+        return getExpectedRunningTime([&](int seed){
+            auto optimizer=cuckoo::makeOptimizer(objFn, getBounds(dimension), 25, maxMC, target, seed);
+            optimizer.setDiscovery(discovery);
+            return optimizer;
+        }, numSeeds, target);
+    };
+    auto compare=[&](const std::string& name, const auto& objFn, int dimension, int maxMC){
+        const auto random=evaluationsToTarget(objFn, dimension, maxMC, cuckoo::Discovery::random);
+        const auto differential=evaluationsToTarget(objFn, dimension, maxMC, cuckoo::Discovery::differential);
+        std::cout<<name<<" evaluations to "<<target<<", random: "<<random<<", differential: "<<differential<<std::endl;
+        return differential;
+    };
+    REQUIRE(compare("u^2 15-d", u2, 15, 25000)<evaluationsToTarget(u2, 15, 25000, cuckoo::Discovery::random));
+    compare("Rosenbrock 2-d", rosenbrok, 2, 5000);
+    compare("Rastrigin 2-d", rastrigin, 2, 5000);
+}
+TEST_CASE("Test adaptive cuckoo search", "[Cuckoo]"){
+    std::vector<swarm_utils::upper_lower<double> > ul(4, swarm_utils::upper_lower<double>(-5.0, 5.0));
+    auto u2=[](const std::vector<double>& inputs){
+        return futilities::sum(inputs, [](const auto& v, const auto& index){
+            return futilities::const_power(v-1.0, 2);
+        });
+    };
+    auto optimizer=cuckoo::makeOptimizer(u2, ul, 25, 1000, 1e-10, 42);
+    optimizer.setAdaptive(true);
+    while(optimizer.step()){}
+    REQUIRE(optimizer.best().second<=1e-10);
+    const auto& adaptation=optimizer.adaptationState();
+    REQUIRE(adaptation.meanScale!=.01);
+    REQUIRE(adaptation.meanLambda>=adaptation.minLambda);
+    REQUIRE(adaptation.meanLambda<=adaptation.maxLambda);
+    REQUIRE(adaptation.meanPA>=adaptation.minPA);
+    REQUIRE(adaptation.meanPA<=adaptation.maxPA);
+    //the mode is off by default, so seeded runs are unchanged: recorded
+    //before adaptation was added
+    auto reference=cuckoo::makeOptimizer(u2, ul, 25, 50, 0.0, 42);
+    while(reference.step()){}
+    REQUIRE(reference.evaluations()==1600);
+    REQUIRE(reference.best().second==Approx(0.016297019239035343).epsilon(1e-12));
+    REQUIRE(reference.best().first[0]==Approx(1.0377521360028874).epsilon(1e-12));
+}
+TEST_CASE("Benchmark adaptive cuckoo search", "[Cuckoo][.]"){
+    const double target=1e-6;
+    const int numSeeds=5;
+    const int dimension=5;
+    const long long maxEvaluations=10000*dimension;
+    auto evaluationsToTarget=[&](const swarm_utils::Problem& problem, bool adaptive){
+        return getExpectedRunningTime([&](int seed){
+            auto optimizer=cuckoo::makeOptimizer(
+                problem.objective, problem.bounds, 25, maxEvaluations/25, target, seed, 
+                swarm_utils::EvaluationBudget().withMaxEvaluations(maxEvaluations)
+            );
+            optimizer.setAdaptive(adaptive);
+            return optimizer;
+        }, numSeeds, target);
+    };
+    int numBetter=0;
+    int numWorse=0;
+    for(const auto& problem:swarm_utils::getProblems(dimension, 2018)){
+        const double fixed=evaluationsToTarget(problem, false);
+        const double adaptive=evaluationsToTarget(problem, true);
+        numBetter+=adaptive<fixed;
+        numWorse+=adaptive>fixed;
+        std::cout<<problem.name<<" "<<dimension<<"-d evaluations to "<<target<<", fixed: "<<fixed<<", adaptive: "<<adaptive<<std::endl;
+        //adaptation does not lose a problem the fixed parameters solve
+        REQUIRE((std::isinf(fixed)||!std::isinf(adaptive)));
+    }
+    std::cout<<"adaptive better on "<<numBetter<<", worse on "<<numWorse<<std::endl;
+    REQUIRE(numBetter>=numWorse);
+}
+TEST_CASE("Test initial sampling", "[Sampling]"){
+    swarm_utils::RandomGenerator rng(3);
+    auto unifL=[&](){return rng.getUniform();};
+    const int n=64;
+    const int dimension=25;
+    auto inUnitCube=[&](const std::vector<std::vector<double> >& points){
+        bool result=points.size()==n;
+        for(const auto& point:points){
+            result=result&&point.size()==dimension;
+            for(const auto& v:point){
+                result=result&&v>=0.0&&v<1.0;
+            }
+        }
+        return result;
+    };
+    //every one of the n strata of every dimension holds exactly one point
+    auto isStratified=[&](const std::vector<std::vector<double> >& points, int numDimensions){
+        bool result=true;
+        for(int j=0; j<numDimensions; ++j){
+            std::vector<int> counts(n, 0);
+            for(const auto& point:points){
+                ++counts[(int)(point[j]*n)];
+            }
+            result=result&&std::all_of(counts.begin(), counts.end(), [](const auto& count){return count==1;});
+        }
+        return result;
+    };
+    SECTION("Latin hypercube"){
+        const auto points=swarm_utils::LatinHypercubeSampling()(n, dimension, unifL);
+        REQUIRE(inUnitCube(points));
+        REQUIRE(isStratified(points, dimension));
+    }
+    SECTION("Sobol"){
+        //the first 2^k points of a digitally shifted Sobol sequence are
+        //stratified in each dimension, including those past the table
+        const auto points=swarm_utils::SobolSampling()(n, dimension, unifL);
+        REQUIRE(inUnitCube(points));
+        REQUIRE(isStratified(points, dimension));
+        //and in pairs of dimensions, on a 8 by 8 grid
+        std::vector<int> counts(n, 0);
+        for(const auto& point:points){
+            ++counts[(int)(point[1]*8)*8+(int)(point[2]*8)];
+        }
+        REQUIRE(std::all_of(counts.begin(), counts.end(), [](const auto& count){return count==1;}));
+        for(int j=1; j<=20; ++j){
+            REQUIRE(swarm_utils::SobolSampling::isPrimitive(
+                swarm_utils::SobolSampling::getDirectionTable()[j-1].first.first,
+                swarm_utils::SobolSampling::getDirectionTable()[j-1].first.second
+            ));
+        }
+    }
+    SECTION("Halton"){
+        const auto points=swarm_utils::HaltonSampling()(n, dimension, unifL);
+        REQUIRE(inUnitCube(points));
+        //base 2 with a shift: one point in each half, quarter, ...
+        std::vector<int> counts(32, 0);
+        for(int i=0; i<32; ++i){
+            ++counts[(int)(points[i][0]*32)];
+        }
+        REQUIRE(std::all_of(counts.begin(), counts.end(), [](const auto& count){return count==1;}));
+    }
+    SECTION("Population"){
+        std::vector<swarm_utils::upper_lower<double> > ul(2, swarm_utils::upper_lower<double>(-2.0, 6.0));
+        auto sum=[](const std::vector<double>& x){return x[0]+x[1];};
+        const auto population=swarm_utils::getSampledPopulation(ul, swarm_utils::SobolSampling(), sum, unifL, n);
+        REQUIRE(population.size()==n);
+        for(const auto& member:population){
+            REQUIRE(member.first[0]>=-2.0);
+            REQUIRE(member.first[0]<6.0);
+            REQUIRE(member.second==sum(member.first));
+        }
+    }
+    SECTION("Better first nests than the default"){
+        //the default draws concentrate in the middle of the box, the Sobol
+        //points cover it, which pays off on the 10-d sphere and rastrigin
+        const auto problemSet=swarm_utils::getProblems(10, 2018);
+        for(const auto& problem:{problemSet[0], problemSet[4]}){
+            double normal=0.0;
+            double sobol=0.0;
+            for(int seed=0; seed<20; ++seed){
+                normal+=cuckoo::makeOptimizer(problem.objective, problem.bounds, 25, 1, 0.0, seed).best().second;
+                sobol+=cuckoo::makeOptimizerFromSampling(problem.objective, problem.bounds, swarm_utils::SobolSampling(), 25, 1, 0.0, seed).best().second;
+            }
+            REQUIRE(sobol<normal);
+        }
+    }
+}
+TEST_CASE("Benchmark initial sampling", "[Sampling][.]"){
+    const int numSeeds=20;
+    const int n=25;
+    for(int dimension:{2, 10}){
+        const auto problemSet=swarm_utils::getProblems(dimension, 2018);
+        //mean over seeds of the best of the first n evaluations, relative to
+        //the default initialization
+        auto meanBest=[&](const swarm_utils::Problem& problem, const auto& makeOptimizer){
+            double total=0.0;
+            for(int seed=0; seed<numSeeds; ++seed){
+                total+=makeOptimizer(problem, seed).best().second;
+            }
+            return total/numSeeds;
+        };
+        for(const auto& problem:problemSet){
+            auto makeDefault=[](const auto& problem, int seed){
+                return cuckoo::makeOptimizer(problem.objective, problem.bounds, n, 1, 0.0, seed);
+            };
+            auto makeSampled=[](const auto& sampler){
+                return [=](const auto& problem, int seed){
+                    return cuckoo::makeOptimizerFromSampling(problem.objective, problem.bounds, sampler, n, 1, 0.0, seed);
+                };
+            };
+            const double normal=meanBest(problem, makeDefault);
+            const double halton=meanBest(problem, makeSampled(swarm_utils::HaltonSampling()));
+            const double sobol=meanBest(problem, makeSampled(swarm_utils::SobolSampling()));
+            const double latin=meanBest(problem, makeSampled(swarm_utils::LatinHypercubeSampling()));
+            std::cout<<problem.name<<" "<<dimension<<"-d mean best of "<<n<<" initial nests, normal: "<<normal;
+            std::cout<<", halton: "<<halton<<", sobol: "<<sobol<<", latin hypercube: "<<latin<<std::endl;
+            REQUIRE(sobol<normal);
+        }
+    }
+}
+TEST_CASE("Test firefly initial sampling", "[Sampling]"){
+    std::vector<swarm_utils::upper_lower<double> > ul(3, swarm_utils::upper_lower<double>(-1.0, 1.0));
+    auto sum=[](const std::vector<double>& x){return x[0]+x[1]+x[2];};
+    const auto optimizer=firefly::makeOptimizerFromSampling(sum, ul, swarm_utils::HaltonSampling(), 20, 1, 4);
+    for(const auto& member:optimizer.population()){
+        for(const auto& v:member.first){
+            REQUIRE(v>=-1.0);
+            REQUIRE(v<1.0);
+        }
+    }
+}
+TEST_CASE("Test opposition based learning", "[Opposition]"){
+    auto sum=[](const std::vector<double>& x){return x[0]+x[1];};
+    std::vector<swarm_utils::upper_lower<double> > ul(2, swarm_utils::upper_lower<double>(-1.0, 3.0));
+    SECTION("Keeps the best of the members and their opposites"){
+        swarm_utils::Population population={{{0.0, 0.0}, 0.0}, {{2.5, 2.5}, 5.0}, {{-1.0, 1.0}, 0.0}};
+        swarm_utils::Population opposites;
+        const std::vector<double> lower={-1.0, -1.0};
+        const std::vector<double> upper={3.0, 3.0};
+        swarm_utils::keepBestOfOpposites(&population, &opposites, lower, upper, sum);
+        //opposites are (2, 2)=4, (-.5, -.5)=-1 and (3, 1)=4
+        REQUIRE(population.size()==3);
+        REQUIRE(population[0].second==-1.0);
+        REQUIRE(population[0].first[0]==-.5);
+        REQUIRE(population[1].second==0.0);
+        REQUIRE(population[2].second==0.0);
+        REQUIRE(opposites.size()==3);
+    }
+    SECTION("Clamps opposites into the box"){
+        swarm_utils::Population population={{{4.0, 4.0}, 8.0}};
+        swarm_utils::addOpposites(&population, ul, sum);
+        REQUIRE(population[0].first[0]==-1.0);
+        REQUIRE(population[0].second==-2.0);
+    }
+    SECTION("Jumps within the box spanned by the population"){
+        swarm_utils::Population population={{{0.0, 1.0}, 1.0}, {{1.0, 2.0}, 3.0}};
+        swarm_utils::Population opposites;
+        swarm_utils::jumpToOpposites(&population, &opposites, sum);
+        //opposites are (1, 2)=3 and (0, 1)=1
+        REQUIRE(population[0].second==1.0);
+        REQUIRE(population[1].second==1.0);
+    }
+    SECTION("Off by default"){
+        std::vector<swarm_utils::upper_lower<double> > box(4, swarm_utils::upper_lower<double>(-5.0, 5.0));
+        auto u2=[](const std::vector<double>& x){return futilities::sum(x, [](const auto& v, const auto& index){return v*v;});};
+        auto jumping=cuckoo::makeOptimizer(u2, box, 25, 50, 0.0, 3);
+        auto reference=cuckoo::makeOptimizer(u2, box, 25, 50, 0.0, 3);
+        jumping.setOppositionJumping(0.0);
+        while(jumping.step()){}
+        while(reference.step()){}
+        REQUIRE(jumping.best().second==reference.best().second);
+        auto opposition=cuckoo::makeOptimizerWithOpposition(u2, box, 25, 50, 0.0, 3);
+        REQUIRE(opposition.evaluations()==50);
+        REQUIRE(opposition.population().size()==25);
+    }
+    SECTION("Firefly"){
+        std::vector<swarm_utils::upper_lower<double> > box(4, swarm_utils::upper_lower<double>(-5.0, 5.0));
+        auto u2=[](const std::vector<double>& x){return futilities::sum(x, [](const auto& v, const auto& index){return v*v;});};
+        //off by default, so seeded runs are unchanged: recorded before
+        //opposition was added
+        auto reference=firefly::makeOptimizer(u2, box, 20, 3);
+        while(reference.step()){}
+        REQUIRE(reference.evaluations()==6464);
+        REQUIRE(reference.best().second==Approx(0.30368459353154387).epsilon(1e-12));
+        REQUIRE(reference.best().first[0]==Approx(-0.17972234839228585).epsilon(1e-12));
+        //the jump is drawn after the moves, so the first generation only
+        //adds the evaluations of the n opposites
+        auto jumping=firefly::makeOptimizer(u2, box, 20, 3);
+        auto plain=firefly::makeOptimizer(u2, box, 20, 3);
+        jumping.setOppositionJumping(1.0);
+        jumping.step();
+        plain.step();
+        REQUIRE(jumping.evaluations()==plain.evaluations()+firefly::n);
+        REQUIRE(jumping.population().size()==firefly::n);
+        REQUIRE(jumping.best().second<=plain.best().second);
+        REQUIRE(std::is_sorted(jumping.population().begin(), jumping.population().end(), [](const auto& a, const auto& b){return a.second<b.second;}));
+        //initialization evaluates the fireflies and their opposites and keeps the best n
+        auto opposition=firefly::makeOptimizerWithOpposition(u2, box, 20, 3);
+        auto random=firefly::makeOptimizer(u2, box, 20, 3);
+        REQUIRE(opposition.evaluations()==2*firefly::n);
+        REQUIRE(opposition.population().size()==firefly::n);
+        for(int i=0; i<firefly::n; ++i){
+            REQUIRE(opposition.population()[i].second<=random.population()[i].second);
+        }
+    }
+}
+TEST_CASE("Benchmark opposition based learning", "[Opposition][.]"){
+    const double target=1e-6;
+    //the firefly algorithm rarely gets much closer in this budget
+    const double fireflyTarget=1e-1;
+    const int numSeeds=5;
+    auto evaluationsToTarget=[&](const swarm_utils::Problem& problem, const auto& makeOptimizer, double target){
+        const long long maxEvaluations=10000*problem.bounds.size();
+        return getExpectedRunningTime([&](int seed){
+            return makeOptimizer(problem, seed, swarm_utils::EvaluationBudget().withMaxEvaluations(maxEvaluations));
+        }, numSeeds, target);
+    };
+    auto cuckooOptimizer=[&](bool opposition, double jumpingRate){
+        return [=](const swarm_utils::Problem& problem, int seed, const swarm_utils::EvaluationBudget& budget){
+            const int totalMC=10000*problem.bounds.size()/25;
+            auto optimizer=opposition?
+                cuckoo::makeOptimizerWithOpposition(problem.objective, problem.bounds, 25, totalMC, target, seed, budget):
+                cuckoo::makeOptimizer(problem.objective, problem.bounds, 25, totalMC, target, seed, budget);
+            optimizer.setOppositionJumping(jumpingRate);
+            return optimizer;
+        };
+    };
+    auto fireflyOptimizer=[&](bool opposition, double jumpingRate){
+        return [=](const swarm_utils::Problem& problem, int seed, const swarm_utils::EvaluationBudget& budget){
+            const int totalMC=10000*problem.bounds.size()/firefly::n;
+            auto optimizer=opposition?
+                firefly::makeOptimizerWithOpposition(problem.objective, problem.bounds, totalMC, seed, firefly::AllPairsUpdate(), budget):
+                firefly::makeOptimizer(problem.objective, problem.bounds, totalMC, seed, firefly::AllPairsUpdate(), budget);
+            optimizer.setOppositionJumping(jumpingRate);
+            return optimizer;
+        };
+    };
+    for(int dimension:{2, 5}){
+    for(const auto& problem:swarm_utils::getProblems(dimension, 2018)){
+        std::cout<<problem.name<<" "<<dimension<<"-d evaluations to "<<target;
+        std::cout<<", cuckoo: "<<evaluationsToTarget(problem, cuckooOptimizer(false, 0.0), target);
+        std::cout<<", opposite start: "<<evaluationsToTarget(problem, cuckooOptimizer(true, 0.0), target);
+        std::cout<<", with jumping: "<<evaluationsToTarget(problem, cuckooOptimizer(true, .3), target);
+        std::cout<<"; firefly to "<<fireflyTarget<<": "<<evaluationsToTarget(problem, fireflyOptimizer(false, 0.0), fireflyTarget);
+        std::cout<<", opposite start: "<<evaluationsToTarget(problem, fireflyOptimizer(true, 0.0), fireflyTarget);
+        std::cout<<", with jumping: "<<evaluationsToTarget(problem, fireflyOptimizer(true, .3), fireflyTarget)<<std::endl;
+    }
+    }
+}
+TEST_CASE("Test RBF surrogate", "[Surrogate]"){
+    swarm_utils::RandomGenerator rng(5);
+    swarm_utils::RbfSurrogate surrogate(50);
+    auto quadratic=[](const std::vector<double>& x){return x[0]*x[0]+2*x[1]*x[1]+x[0]*x[1];};
+    std::vector<std::vector<double> > points;
+    REQUIRE(!surrogate.fit());
+    for(int i=0; i<60; ++i){
+        points.push_back({2*rng.getUniform()-1, 2*rng.getUniform()-1});
+        surrogate.add(points.back(), quadratic(points.back()));
+        //duplicates are ignored
+        surrogate.add(points.back(), quadratic(points.back()));
+    }
+    REQUIRE(surrogate.size()==50);
+    REQUIRE(surrogate.fit());
+    REQUIRE(surrogate.ready());
+    //interpolates the last 50 points
+    for(int i=10; i<60; ++i){
+        REQUIRE(surrogate.predict(points[i])==Approx(quadratic(points[i])).epsilon(1e-6));
+    }
+    //and is close in between
+    for(int i=0; i<20; ++i){
+        const std::vector<double> x={rng.getUniform()-.5, rng.getUniform()-.5};
+        REQUIRE(std::abs(surrogate.predict(x)-quadratic(x))<.05);
+    }
+    surrogate.add(std::vector<double>{.3, .3}, 0.0);
+    REQUIRE(!surrogate.ready());
+}
+TEST_CASE("Test surrogate screening", "[Surrogate]"){
+    std::vector<swarm_utils::upper_lower<double> > ul(5, swarm_utils::upper_lower<double>(-5.0, 5.0));
+    auto u2=[](const std::vector<double>& x){return futilities::sum(x, [](const auto& v, const auto& index){return (v-1)*(v-1);});};
+    auto screened=cuckoo::makeOptimizer(u2, ul, 25, 100, 0.0, 7);
+    auto reference=cuckoo::makeOptimizer(u2, ul, 25, 100, 0.0, 7);
+    screened.setSurrogate(100);
+    while(screened.step()){}
+    while(reference.step()){}
+    const auto statistics=screened.statistics();
+    REQUIRE(statistics.screenedEvaluations>0);
+    REQUIRE(statistics.surrogateTicks>0);
+    REQUIRE(screened.evaluations()+statistics.screenedEvaluations==reference.evaluations());
+    REQUIRE(screened.best().second<1e-2);
+    REQUIRE(reference.statistics().screenedEvaluations==0);
+}
+TEST_CASE("Benchmark surrogate screening", "[Surrogate][.]"){
+    const double target=1e-6;
+    const int numSeeds=5;
+    for(const auto& problem:swarm_utils::getProblems(5, 2018)){
+        const long long maxEvaluations=10000*problem.bounds.size();
+        for(int archiveSize:{0, 100}){
+            long long screenedEvaluations=0;
+            double surrogateSeconds=0.0;
+            int iterations=0;
+            const double evaluations=getExpectedRunningTime([&](int seed){
+                auto optimizer=cuckoo::makeOptimizer(
+                    problem.objective, problem.bounds, 25, maxEvaluations/25, target, seed, 
+                    swarm_utils::EvaluationBudget().withMaxEvaluations(maxEvaluations)
+                );
+                optimizer.setSurrogate(archiveSize);
+                return optimizer;
+            }, numSeeds, target, [&](const auto& optimizer){
+                const auto statistics=optimizer.statistics();
+                screenedEvaluations+=statistics.screenedEvaluations;
+                surrogateSeconds+=swarm_utils::RunStatistics::seconds(statistics.surrogateTicks);
+                iterations+=statistics.iterations;
+            });
+            std::cout<<problem.name<<" 5-d, archive "<<archiveSize<<": evaluations to "<<target<<" "<<evaluations;
+            std::cout<<", screened "<<(double)screenedEvaluations/iterations<<" per generation, surrogate ";
+            std::cout<<1e6*surrogateSeconds/std::max(iterations, 1)<<" us per generation"<<std::endl;
+        }
+    }
+}
+TEST_CASE("Test Nelder-Mead", "[LocalSearch]"){
+    std::vector<swarm_utils::upper_lower<double> > ul(2, swarm_utils::upper_lower<double>(-4.0, 4.0));
+    int numCalls=0;
+    auto rosenbrok=[&](const std::vector<double>& inputs){
+        ++numCalls;
+        return futilities::const_power(1-inputs[0], 2)+100*futilities::const_power(inputs[1]-futilities::const_power(inputs[0], 2), 2);
+    };
+    const std::vector<double> start={-1.2, 1.0};
+    SECTION("Converges on Rosenbrock"){
+        const auto result=swarm_utils::nelderMead(start, rosenbrok(start), ul, rosenbrok, 1000, .05, 1e-10);
+        REQUIRE(result.second<=1e-10);
+        REQUIRE(result.first[0]==Approx(1.0).epsilon(1e-4));
+        REQUIRE(numCalls<=1001);
+    }
+    SECTION("Respects the evaluation limit"){
+        swarm_utils::nelderMead(start, rosenbrok(start), ul, rosenbrok, 20, .05, 0.0);
+        REQUIRE(numCalls==21);
+    }
+    SECTION("Stays in the box"){
+        std::vector<swarm_utils::upper_lower<double> > box(2, swarm_utils::upper_lower<double>(-4.0, 4.0));
+        box[0].upper=.5;
+        const auto result=swarm_utils::nelderMead(start, rosenbrok(start), box, rosenbrok, 1000, .05, 0.0);
+        REQUIRE(result.first[0]<=.5);
+        //the constrained minimum is on the face x=.5, at y=.25
+        REQUIRE(result.first[0]==Approx(.5).epsilon(1e-4));
+        REQUIRE(result.first[1]==Approx(.25).epsilon(1e-3));
+    }
+}
+TEST_CASE("Test hybrid refinement", "[LocalSearch]"){
+    std::vector<swarm_utils::upper_lower<double> > ul(2, swarm_utils::upper_lower<double>(-4.0, 4.0));
+    auto rosenbrok=[](const std::vector<double>& inputs){
+        return futilities::const_power(1-inputs[0], 2)+100*futilities::const_power(inputs[1]-futilities::const_power(inputs[0], 2), 2);
+    };
+    auto pure=cuckoo::makeOptimizer(rosenbrok, ul, 20, 10000, .00000001, 42);
+    while(pure.step()){}
+    auto hybrid=cuckoo::makeOptimizer(rosenbrok, ul, 20, 10000, .00000001, 42);
+    hybrid.setLocalRefinement(swarm_utils::LocalRefinement().withPeriod(50).withStagnation(10));
+    while(hybrid.step()){}
+    std::cout<<"Rosenbrok evaluations to 1e-8, pure: "<<pure.evaluations()<<", hybrid: "<<hybrid.evaluations();
+    std::cout<<" ("<<hybrid.statistics().refinementEvaluations<<" in local search)"<<std::endl;
+    REQUIRE(hybrid.best().second<=.00000001);
+    REQUIRE(hybrid.evaluations()<pure.evaluations());
+    REQUIRE(hybrid.statistics().refinementEvaluations>0);
+    REQUIRE(pure.statistics().refinementEvaluations==0);
+    //refinement shares the budget
+    auto limited=cuckoo::makeOptimizer(rosenbrok, ul, 20, 10000, 0.0, 42, swarm_utils::EvaluationBudget().withMaxEvaluations(500));
+    limited.setLocalRefinement(swarm_utils::LocalRefinement().withPeriod(1));
+    while(limited.step()){}
+    REQUIRE(limited.evaluations()==500);
+}
+TEST_CASE("Benchmark hybrid refinement", "[LocalSearch][.]"){
+    const double target=1e-6;
+    const int numSeeds=5;
+    for(int dimension:{2, 5}){
+        for(const auto& problem:swarm_utils::getProblems(dimension, 2018)){
+            const long long maxEvaluations=10000*problem.bounds.size();
+            auto evaluationsToTarget=[&](bool hybrid){
+                return getExpectedRunningTime([&](int seed){
+                    auto optimizer=cuckoo::makeOptimizer(
+                        problem.objective, problem.bounds, 25, maxEvaluations/25, target, seed, 
+                        swarm_utils::EvaluationBudget().withMaxEvaluations(maxEvaluations)
+                    );
+                    if(hybrid){
+                        optimizer.setLocalRefinement(swarm_utils::LocalRefinement().withPeriod(50).withStagnation(10).withMaxEvaluations(50*dimension));
+                    }
+                    return optimizer;
+                }, numSeeds, target);
+            };
+            std::cout<<problem.name<<" "<<dimension<<"-d evaluations to "<<target;
+            std::cout<<", pure: "<<evaluationsToTarget(false)<<", hybrid: "<<evaluationsToTarget(true)<<std::endl;
+        }
+    }
+}
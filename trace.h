@@ -0,0 +1,259 @@
+#ifndef __SWARM_TRACE_H__
+#define __SWARM_TRACE_H__
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <stdexcept>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include "observer.h"
+
+namespace swarm_utils{
+    /**Binary layout (native endianness):
+        header: 8 byte magic "SWRMTRC1", uint32 numParams
+        chunk: uint32 numBytes, uint32 numRecords, records[numRecords]
+        generation record: uint8 'G', int64 iteration, uint32 populationSize,
+            double values[populationSize] (ranked, so values[0] is the best)
+        evaluation record: uint8 'E', double params[numParams], double value
+    A run that crashes loses at most the chunks not yet written; the reader
+    stops at the first incomplete chunk.*/
+    namespace trace{
+        constexpr uint8_t generationTag='G';
+        constexpr uint8_t evaluationTag='E';
+        inline const char* getMagic(){
+            return "SWRMTRC1";
+        }
+    }
+
+    /**Observer that records the best value and the value of every member each
+    generation and, if recordEvaluations, every evaluated point.  Records are
+    appended to a ring of numChunks chunks of about chunkSize bytes; a
+    background thread writes full chunks to disk, so the optimizer only
+    copies bytes.  The optimizer waits only if every chunk is full.  Pass it
+    by pointer to optimize; the file is complete once close returns or the
+    recorder is destroyed.*/
+    class TraceRecorder: public NullObserver{
+    private:
+        struct Chunk{
+            std::vector<unsigned char> data;
+            uint32_t numRecords=0;
+        };
+        std::vector<Chunk> chunks;
+        std::size_t chunkSize;
+        int numParams;
+        bool recordEvaluations;
+        int current=0;//chunk being filled, owned by the optimizer thread
+        int nextToWrite=0;
+        int numFull=0;
+        bool done=false;
+        bool closed=false;
+        std::atomic<bool> failed{false};
+        FILE* file;
+        std::mutex mutex;
+        std::condition_variable signal;
+        std::thread writer;
+
+        void run(){
+            std::unique_lock<std::mutex> lock(mutex);
+            while(true){
+                signal.wait(lock, [&](){return numFull>0||done;});
+                if(numFull==0){
+                    return;
+                }
+                Chunk& chunk=chunks[nextToWrite];
+                lock.unlock();
+                const uint32_t chunkHeader[2]={(uint32_t)chunk.data.size(), chunk.numRecords};
+                if(fwrite(chunkHeader, sizeof(uint32_t), 2, file)!=2||fwrite(chunk.data.data(), 1, chunk.data.size(), file)!=chunk.data.size()){
+                    failed=true;
+                }
+                chunk.data.clear();
+                chunk.numRecords=0;
+                lock.lock();
+                nextToWrite=(nextToWrite+1)%chunks.size();
+                --numFull;
+                signal.notify_all();
+            }
+        }
+        /**Hands the current chunk to the writer and moves to the next one*/
+        void submit(){
+            std::unique_lock<std::mutex> lock(mutex);
+            ++numFull;
+            signal.notify_all();
+            signal.wait(lock, [&](){return numFull<(int)chunks.size();});
+            current=(current+1)%chunks.size();
+        }
+        /**Space for a record of numBytes in the current chunk*/
+        unsigned char* reserve(std::size_t numBytes){
+            Chunk* chunk=&chunks[current];
+            if(!chunk->data.empty()&&chunk->data.size()+numBytes>chunkSize){
+                submit();
+                chunk=&chunks[current];
+            }
+            const std::size_t offset=chunk->data.size();
+            chunk->data.resize(offset+numBytes);
+            ++chunk->numRecords;
+            return chunk->data.data()+offset;
+        }
+    public:
+        TraceRecorder(const std::string& path, int numParams_, bool recordEvaluations_=false, std::size_t chunkSize_=1<<20, int numChunks=4):
+            chunks(numChunks<2?2:numChunks),
+            chunkSize(chunkSize_),
+            numParams(numParams_),
+            recordEvaluations(recordEvaluations_)
+        {
+            file=fopen(path.c_str(), "wb");
+            if(!file){
+                throw std::runtime_error("TraceRecorder: unable to open "+path);
+            }
+            const uint32_t header=numParams;
+            if(fwrite(trace::getMagic(), 1, 8, file)!=8||fwrite(&header, sizeof(uint32_t), 1, file)!=1){
+                fclose(file);
+                throw std::runtime_error("TraceRecorder: unable to write header to "+path);
+            }
+            for(auto& chunk:chunks){
+                chunk.data.reserve(chunkSize);
+            }
+            writer=std::thread([this](){run();});
+        }
+        TraceRecorder(const TraceRecorder&)=delete;
+        TraceRecorder& operator=(const TraceRecorder&)=delete;
+        ~TraceRecorder(){
+            close();
+        }
+        /**Writes the remaining records and closes the file; returns false if
+        any write failed*/
+        bool close(){
+            if(closed){
+                return !failed;
+            }
+            closed=true;
+            if(!chunks[current].data.empty()){
+                submit();
+            }
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                done=true;
+            }
+            signal.notify_all();
+            writer.join();
+            if(fclose(file)!=0){
+                failed=true;
+            }
+            return !failed;
+        }
+        template<typename Population>
+        void onGenerationEnd(int iteration, const Population& population){
+            const uint32_t populationSize=population.size();
+            const int64_t iteration64=iteration;
+            unsigned char* record=reserve(1+sizeof(int64_t)+sizeof(uint32_t)+sizeof(double)*populationSize);
+            *record=trace::generationTag;
+            std::memcpy(record+1, &iteration64, sizeof(int64_t));
+            std::memcpy(record+1+sizeof(int64_t), &populationSize, sizeof(uint32_t));
+            record+=1+sizeof(int64_t)+sizeof(uint32_t);
+            for(uint32_t i=0; i<populationSize; ++i){
+                const double value=population[i].second;
+                std::memcpy(record+sizeof(double)*i, &value, sizeof(double));
+            }
+        }
+        template<typename Params>
+        void onEvaluation(const Params& params, double value){
+            if(!recordEvaluations){
+                return;
+            }
+            unsigned char* record=reserve(1+sizeof(double)*(numParams+1));
+            *record=trace::evaluationTag;
+            for(int i=0; i<numParams; ++i){
+                const double v=params[i];
+                std::memcpy(record+1+sizeof(double)*i, &v, sizeof(double));
+            }
+            std::memcpy(record+1+sizeof(double)*numParams, &value, sizeof(double));
+        }
+    };
+
+    /**Converts a trace to CSV.  generations gets one row per generation,
+    "iteration,best,value0,value1,..."; evaluations gets one row per
+    evaluated point, "param0,param1,...,value".  Returns false if the file
+    is missing or not a trace, or if a record runs past the end of its
+    chunk; a torn final chunk is skipped.*/
+    inline bool traceToCsv(const std::string& path, std::ostream& generations, std::ostream& evaluations){
+        FILE* file=fopen(path.c_str(), "rb");
+        if(!file){
+            return false;
+        }
+        char magic[8];
+        uint32_t numParams=0;
+        bool ok=fread(magic, 1, 8, file)==8&&std::memcmp(magic, trace::getMagic(), 8)==0;
+        ok=ok&&fread(&numParams, sizeof(uint32_t), 1, file)==1;
+        std::vector<unsigned char> data;
+        std::vector<double> values;
+        generations.precision(17);
+        evaluations.precision(17);
+        while(ok){
+            uint32_t chunkHeader[2];
+            if(fread(chunkHeader, sizeof(uint32_t), 2, file)!=2){
+                break;
+            }
+            data.resize(chunkHeader[0]);
+            if(fread(data.data(), 1, data.size(), file)!=data.size()){
+                break;
+            }
+            const unsigned char* record=data.data();
+            const unsigned char* end=record+data.size();
+            //sizes come from the file, so every read is checked against the chunk
+            auto fits=[&](size_t needed){
+                return (size_t)(end-record)>=needed;
+            };
+            for(uint32_t r=0; r<chunkHeader[1]&&record<end; ++r){
+                if(*record==trace::generationTag){
+                    int64_t iteration;
+                    uint32_t populationSize;
+                    if(!fits(1+sizeof(int64_t)+sizeof(uint32_t))){
+                        ok=false;
+                        break;
+                    }
+                    std::memcpy(&iteration, record+1, sizeof(int64_t));
+                    std::memcpy(&populationSize, record+1+sizeof(int64_t), sizeof(uint32_t));
+                    record+=1+sizeof(int64_t)+sizeof(uint32_t);
+                    if(!fits(sizeof(double)*populationSize)){
+                        ok=false;
+                        break;
+                    }
+                    values.resize(populationSize);
+                    std::memcpy(values.data(), record, sizeof(double)*populationSize);
+                    record+=sizeof(double)*populationSize;
+                    generations<<iteration<<","<<(populationSize>0?values[0]:0.0);
+                    for(const auto& v:values){
+                        generations<<","<<v;
+                    }
+                    generations<<"\n";
+                }
+                else if(*record==trace::evaluationTag){
+                    if(!fits(1+sizeof(double)*(numParams+(size_t)1))){
+                        ok=false;
+                        break;
+                    }
+                    values.resize(numParams+1);
+                    std::memcpy(values.data(), record+1, sizeof(double)*(numParams+1));
+                    record+=1+sizeof(double)*(numParams+1);
+                    for(uint32_t i=0; i<numParams; ++i){
+                        evaluations<<values[i]<<",";
+                    }
+                    evaluations<<values[numParams]<<"\n";
+                }
+                else{
+                    ok=false;
+                    break;
+                }
+            }
+        }
+        fclose(file);
+        return ok;
+    }
+}
+
+#endif
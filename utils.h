@@ -2,10 +2,47 @@
 #define __SWARM_UTILS__
 #include "FunctionalUtilities.h"
 #include <cstdlib>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <utility>
+#include <cmath>
+#include <stdexcept>
 namespace swarm_utils{
     auto getUniform(){
         return (double)rand()/RAND_MAX;
     }
+    /**Random number source owned by a single optimization.  Unlike rand() its
+    full state can be saved and restored, so a checkpointed run continues
+    with exactly the same draws.*/
+    class RandomGenerator{
+    private:
+        std::mt19937_64 engine;
+        std::normal_distribution<double> norm;
+        std::uniform_real_distribution<double> unif;
+    public:
+        RandomGenerator(int seed):engine(seed), norm(0.0, 1.0), unif(0.0, 1.0){}
+        double getNorm(){
+            return norm(engine);
+        }
+        /**Uniform on (0, 1], so that it is safe to raise to a negative power*/
+        double getUniform(){
+            return 1.0-unif(engine);
+        }
+        std::string getState() const {
+            std::ostringstream state;
+            state<<engine<<" "<<norm;
+            return state.str();
+        }
+        /**Returns false, leaving the generator unspecified, if stateString
+        was not produced by getState*/
+        bool setState(const std::string& stateString){
+            std::istringstream state(stateString);
+            state>>engine>>norm;
+            return !state.fail();
+        }
+    };
     template<typename T, typename U>
     auto getTruncatedParameter(const T& lower, const T& upper, const U& result){
         return result>upper?upper:(result<lower?lower:result);
@@ -30,11 +67,73 @@ namespace swarm_utils{
     auto getLevyFlight(const T& currVal, const T& stepSize, const T& lambda, U&& rand, U&& normRand){
         return currVal+stepSize*getLevy(lambda, rand)*normRand;
     }
+
+    /**Levy step policies: flight(currVal, stepSize, unif, norm) returns the
+    new parameter, drawing from the unif and norm generators.*/
+    /**The original step, a normal draw scaled by unif^(-1/lambda)*/
+    struct PowerLawLevy{
+        double lambda;
+        explicit PowerLawLevy(double lambda_):lambda(lambda_){}
+        template<typename T, typename Unif, typename Norm>
+        auto operator()(const T& currVal, const T& stepSize, const Unif& unif, const Norm& norm) const {
+            return getLevyFlight(currVal, stepSize, lambda, unif(), norm());
+        }
+    };
+    /**Scale of the numerator in Mantegna's algorithm*/
+    inline double getMantegnaSigma(double lambda){
+        const double pi=3.14159265358979323846;
+        return std::pow(
+            std::tgamma(1+lambda)*std::sin(pi*lambda*.5)/(std::tgamma((1+lambda)*.5)*lambda*std::pow(2.0, (lambda-1)*.5)),
+            1.0/lambda
+        );
+    }
+    /**Mantegna's algorithm: u/|v|^(1/lambda) with u normal with standard
+    deviation getMantegnaSigma(lambda) and v standard normal, which follows
+    a Levy stable law of index lambda (0.3 to 1.99).  Its tails fall as
+    |step|^-lambda, like PowerLawLevy's; only the scale differs.  For lambda
+    above 1 sigma is below 1 and the scale is smaller, so for the same
+    stepSize fewer steps end up clamped to the bounds.  sigma is computed
+    once, at construction.*/
+    struct MantegnaLevy{
+        double lambda;
+        double sigma;
+        double inverseLambda;
+        explicit MantegnaLevy(double lambda_):lambda(lambda_), sigma(getMantegnaSigma(lambda_)), inverseLambda(1.0/lambda_){}
+        template<typename T, typename Unif, typename Norm>
+        auto operator()(const T& currVal, const T& stepSize, const Unif& unif, const Norm& norm) const {
+            const double u=sigma*norm();
+            const double v=norm();
+            return currVal+stepSize*u/std::pow(std::abs(v), inverseLambda);
+        }
+    };
     template<typename Array, typename ObjFn, typename Rand>
     auto getNewParameterAndFn(const Array& ul, const ObjFn& objFn, const Rand& rand){
         auto parameters=swarm_utils::getRandomParameters(ul, rand);
         return std::pair<std::vector<double>, double>(parameters, objFn(parameters));
     }
+    /**Population of n members made of the seeds themselves followed by points
+    drawn around the seeds (cycling through them), with rand scaled by
+    spread*(upper-lower).  Used to warm start from previous results.  Throws
+    std::invalid_argument if there are no seeds.*/
+    template<typename Array, typename Seeds, typename ObjFn, typename Rand>
+    auto getSeededPopulation(const Array& ul, const Seeds& seeds, double spread, const ObjFn& objFn, const Rand& rand, int n){
+        const int numSeeds=seeds.size();
+        if(numSeeds==0){
+            throw std::invalid_argument("getSeededPopulation: no seeds");
+        }
+        return futilities::for_each(0, n, [&](const auto& index){
+            const auto& seed=seeds[index%numSeeds];
+            auto parameters=futilities::for_each(0, (int)ul.size(), [&](const auto& j){
+                return getTruncatedParameter(
+                    ul[j].lower, ul[j].upper, 
+                    index<numSeeds?seed[j]:seed[j]+spread*(ul[j].upper-ul[j].lower)*rand()
+                );
+            });
+            return std::pair<std::vector<double>, double>(parameters, objFn(parameters));
+        });
+    }
+    /**Parameters and objective value of every member, as used by both algorithms*/
+    typedef std::vector<std::pair<std::vector<double>, double> > Population;
     constexpr int optparms=0;
     constexpr int fnval=1;
     template<typename T>